@@ -0,0 +1,110 @@
+#include "BatchRunner.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+/*
+	Constructor
+	parameters:
+		tileMap		- map every run starts from, must outlive the runner
+		settings	- settings of every run, the seed and stream are set per run
+		maxTicks	- tick limit of each run
+		threadCount	- number of worker threads, 0 uses every core
+*/
+BatchRunner::BatchRunner(const TileMap& tileMap, const SimulationSettings& settings,
+	long long maxTicks, unsigned int threadCount)
+	: tileMap(tileMap),
+	settings(settings)
+{
+	this->maxTicks = maxTicks;
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	this->threadCount = threadCount > 0 ? threadCount : 1;
+}
+
+/*
+	runs the batch, the worker threads take the next run to simulate until every run is done
+	parameters:
+		runs		- number of runs
+		seed		- seed of the batch, run i uses rng stream i of the seed
+	returns the result of each run, in run order
+*/
+std::vector<SimulationResult> BatchRunner::run(int runs, unsigned long long seed)
+{
+	std::vector<SimulationResult> results(runs > 0 ? runs : 0);
+	std::atomic<int> nextRun(0);
+	auto worker = [&]() {
+		int runIndex;
+		while ((runIndex = nextRun++) < runs) {
+			SimulationSettings runSettings = settings;
+			runSettings.seeded = true;
+			runSettings.seed = seed;
+			runSettings.stream = (unsigned long long)runIndex;
+			Simulation simulation(tileMap, runSettings);
+			results[runIndex] = simulation.run(maxTicks);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	unsigned int workerCount = std::min(threadCount, (unsigned int)std::max(runs, 1));
+	for (unsigned int i = 0; i < workerCount; i++) {
+		workers.push_back(std::thread(worker));
+	}
+	for (unsigned int i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	}
+	return results;
+}
+
+/*
+	computes mean, standard deviation, min and max of the given values
+*/
+static BatchStatistic computeStatistic(const std::vector<double>& values)
+{
+	BatchStatistic statistic;
+	if (values.empty())
+		return statistic;
+	statistic.min = values[0];
+	statistic.max = values[0];
+	double sum = 0;
+	for (unsigned int i = 0; i < values.size(); i++) {
+		sum += values[i];
+		statistic.min = std::min(statistic.min, values[i]);
+		statistic.max = std::max(statistic.max, values[i]);
+	}
+	statistic.mean = sum / values.size();
+	double squaredDeviations = 0;
+	for (unsigned int i = 0; i < values.size(); i++) {
+		squaredDeviations += (values[i] - statistic.mean) * (values[i] - statistic.mean);
+	}
+	statistic.stddev = std::sqrt(squaredDeviations / values.size());
+	return statistic;
+}
+
+/*
+	aggregates the results of a batch
+*/
+BatchSummary BatchRunner::summarize(const std::vector<SimulationResult>& results)
+{
+	BatchSummary summary;
+	std::vector<double> timePassed, rechargeCount, tilesMowed, coverage, ticks;
+	for (unsigned int i = 0; i < results.size(); i++) {
+		summary.runs++;
+		if (results[i].finished)
+			summary.finishedRuns++;
+		if (results[i].stuck)
+			summary.stuckRuns++;
+		timePassed.push_back(results[i].timePassed);
+		rechargeCount.push_back(results[i].rechargeCount);
+		tilesMowed.push_back(results[i].tilesMowed);
+		coverage.push_back(results[i].coverage * 100.0);
+		ticks.push_back((double)results[i].ticks);
+	}
+	summary.timePassed = computeStatistic(timePassed);
+	summary.rechargeCount = computeStatistic(rechargeCount);
+	summary.tilesMowed = computeStatistic(tilesMowed);
+	summary.coverage = computeStatistic(coverage);
+	summary.ticks = computeStatistic(ticks);
+	return summary;
+}
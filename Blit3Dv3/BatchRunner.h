@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include "Simulation.h"
+
+// mean, standard deviation and range of one value over the runs of a batch
+struct BatchStatistic {
+	double mean = 0;
+	double stddev = 0;
+	double min = 0;
+	double max = 0;
+};
+
+// aggregate statistics of a batch of runs
+struct BatchSummary {
+	int runs = 0;
+	int finishedRuns = 0;				// runs where the robot finished before the tick limit
+	int stuckRuns = 0;					// runs stopped by the stuck detection
+	BatchStatistic timePassed;			// in HOURS
+	BatchStatistic rechargeCount;
+	BatchStatistic tilesMowed;
+	BatchStatistic coverage;			// in percent of the lawn
+	BatchStatistic ticks;
+};
+
+/*
+	Runs many independent simulations of the same map and settings on all cores,
+	each run gets its own copy of the map and its own rng stream of the batch seed,
+	so run i of a batch can be replayed alone with the batch seed and stream i.
+*/
+class BatchRunner
+{
+private:
+	// =========== DATA MEMBERS ==============
+	const TileMap& tileMap;				// map every run starts from, only read
+	SimulationSettings settings;		// settings shared by all runs, except for the seed
+	long long maxTicks;					// tick limit of each run
+	unsigned int threadCount;			// worker threads used by run
+public:
+	// =========== FUNCTIONS ====================
+	// refer to cpp files for more detailed explanation
+	BatchRunner(const TileMap& tileMap, const SimulationSettings& settings,
+		long long maxTicks, unsigned int threadCount = 0);
+	std::vector<SimulationResult> run(int runs, unsigned long long seed);
+	static BatchSummary summarize(const std::vector<SimulationResult>& results);
+
+	unsigned int getThreadCount() {
+		return threadCount;
+	}
+};
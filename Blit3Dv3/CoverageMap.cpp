@@ -0,0 +1,195 @@
+#include "CoverageMap.h"
+
+/*
+	number of bits set in a word
+*/
+static inline int popcount(uint64_t word)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(word);
+#else
+	// msvc's __popcnt64 needs a cpu with the popcnt instruction, count the bits by hand instead
+	word = word - ((word >> 1) & 0x5555555555555555ull);
+	word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+	word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+	return (int)((word * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+/*
+	index of the lowest bit set in a word, the word must not be 0
+*/
+static inline int lowestBit(uint64_t word)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(word);
+#else
+	int bit = 0;
+	while (!(word & 1)) {
+		word >>= 1;
+		bit++;
+	}
+	return bit;
+#endif
+}
+
+/*
+	mask of the bits from bit first to bit last of a word, both included
+*/
+static inline uint64_t bitRange(int first, int last)
+{
+	return (~0ull << first) & (~0ull >> (63 - last));
+}
+
+/*
+	Constructor, an empty coverage map of the given size in tiles
+*/
+CoverageMap::CoverageMap(int width, int height)
+	: width(width), height(height),
+	wordsPerRow((width + WORD_BITS - 1) / WORD_BITS)
+{
+	lawn = std::vector<uint64_t>(wordsPerRow * height, 0);
+	mowed = std::vector<uint64_t>(wordsPerRow * height, 0);
+}
+
+/*
+	sets a bit of a plane, returns true if the bit changed
+*/
+bool CoverageMap::setBit(std::vector<uint64_t>& plane, int index, uint64_t bit, bool value)
+{
+	uint64_t previous = plane[index];
+	plane[index] = value ? previous | bit : previous & ~bit;
+	return plane[index] != previous;
+}
+
+/*
+	updates the coverage of a tile, called by the TileMap every time a tile is classified
+	parameters:
+		row, col	- the tile, must be a valid map position
+		isLawn		- the tile is grass, mowed or not
+		isMowed		- the tile is mowed grass
+*/
+void CoverageMap::setTile(int row, int col, bool isLawn, bool isMowed)
+{
+	int index = row * wordsPerRow + col / WORD_BITS;
+	uint64_t bit = 1ull << (col % WORD_BITS);
+	if (setBit(lawn, index, bit, isLawn))
+		lawnCount += isLawn ? 1 : -1;
+	if (setBit(mowed, index, bit, isMowed))
+		mowedCount += isMowed ? 1 : -1;
+}
+
+/*
+	counts the bits set in a rectangle of a plane, the region is clipped to the map
+	parameters: the first and last row and column of the region, all included
+*/
+int CoverageMap::countBits(const std::vector<uint64_t>& plane, int rowMin, int colMin, int rowMax, int colMax) const
+{
+	if (rowMin < 0) rowMin = 0;
+	if (colMin < 0) colMin = 0;
+	if (rowMax >= height) rowMax = height - 1;
+	if (colMax >= width) colMax = width - 1;
+	if (rowMin > rowMax || colMin > colMax)
+		return 0;
+
+	int firstWord = colMin / WORD_BITS, lastWord = colMax / WORD_BITS;
+	uint64_t firstMask = bitRange(colMin % WORD_BITS, WORD_BITS - 1);
+	uint64_t lastMask = bitRange(0, colMax % WORD_BITS);
+	int count = 0;
+	for (int row = rowMin; row <= rowMax; row++) {
+		const uint64_t* words = &plane[row * wordsPerRow];
+		if (firstWord == lastWord) {
+			count += popcount(words[firstWord] & firstMask & lastMask);
+			continue;
+		}
+		count += popcount(words[firstWord] & firstMask);
+		for (int word = firstWord + 1; word < lastWord; word++)
+			count += popcount(words[word]);
+		count += popcount(words[lastWord] & lastMask);
+	}
+	return count;
+}
+
+/*
+	returns the number of mowed tiles in a row
+*/
+int CoverageMap::countMowedInRow(int row) const
+{
+	return countBits(mowed, row, 0, row, width - 1);
+}
+
+/*
+	returns the number of mowed tiles in a rectangle of the map
+	parameters: the first and last row and column of the region, all included
+*/
+int CoverageMap::countMowedInRegion(int rowMin, int colMin, int rowMax, int colMax) const
+{
+	return countBits(mowed, rowMin, colMin, rowMax, colMax);
+}
+
+/*
+	returns the number of lawn tiles, mowed or not, in a rectangle of the map
+	parameters: the first and last row and column of the region, all included
+*/
+int CoverageMap::countLawnInRegion(int rowMin, int colMin, int rowMax, int colMax) const
+{
+	return countBits(lawn, rowMin, colMin, rowMax, colMax);
+}
+
+/*
+	finds the first lawn tile that isn't mowed, in row major order starting at (fromRow, fromCol)
+	parameters:
+		fromRow, fromCol	- where to start looking, this tile included
+		row, col			- set to the tile found
+	returns false if every tile from the starting tile on is mowed
+*/
+bool CoverageMap::findFirstUnmowed(int fromRow, int fromCol, int& row, int& col) const
+{
+	if (fromRow < 0 || width == 0) {
+		fromRow = 0;
+		fromCol = 0;
+	}
+	if (fromCol < 0)
+		fromCol = 0;
+	if (fromCol >= width) {
+		fromRow++;
+		fromCol = 0;
+	}
+	for (int r = fromRow; r < height; r++) {
+		int firstWord = r == fromRow ? fromCol / WORD_BITS : 0;
+		for (int word = firstWord; word < wordsPerRow; word++) {
+			int index = r * wordsPerRow + word;
+			uint64_t unmowed = lawn[index] & ~mowed[index];
+			if (r == fromRow && word == firstWord)
+				unmowed &= bitRange(fromCol % WORD_BITS, WORD_BITS - 1);
+			if (unmowed) {
+				row = r;
+				col = word * WORD_BITS + lowestBit(unmowed);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/*
+	puts back the mowed bits of a snapshot taken on this map
+*/
+void CoverageMap::restore(const Snapshot& snapshot)
+{
+	mowed = snapshot;
+	mowedCount = 0;
+	for (unsigned int i = 0; i < mowed.size(); i++)
+		mowedCount += popcount(mowed[i]);
+}
+
+/*
+	returns the number of tiles mowed since a snapshot taken on this map
+*/
+int CoverageMap::countMowedSince(const Snapshot& snapshot) const
+{
+	int count = 0;
+	for (unsigned int i = 0; i < mowed.size(); i++)
+		count += popcount(mowed[i] & ~snapshot[i]);
+	return count;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/*
+	Mowing coverage of a map, one bit per tile, kept up to date by the TileMap.
+	Every row starts on a new 64 bit word so the coverage of a row or a region is a few popcounts
+	and the next unmowed tile is found a word at a time instead of a tile at a time
+	(see Simulation::getResult). A snapshot of the mowed plane is a copy of its words, the tiles mowed
+	since one are a popcount per word (see the per leg coverage of Simulation::step).
+	The lawn plane holds the tiles that need mowing or are mowed, the mowed plane the mowed ones.
+*/
+class CoverageMap
+{
+public:
+	// the mowed bits at some point in time, see snapshot
+	typedef std::vector<uint64_t> Snapshot;
+private:
+	// =========== DATA MEMBERS ==============
+	static const int WORD_BITS = 64;
+	int width = 0;
+	int height = 0;
+	int wordsPerRow = 0;
+	std::vector<uint64_t> lawn;			// tiles that are mowed or still need mowing
+	std::vector<uint64_t> mowed;		// tiles that are mowed
+	int lawnCount = 0;					// bits set in lawn
+	int mowedCount = 0;					// bits set in mowed
+	int countBits(const std::vector<uint64_t>& plane, int rowMin, int colMin, int rowMax, int colMax) const;
+	static bool setBit(std::vector<uint64_t>& plane, int index, uint64_t bit, bool value);
+public:
+	// =========== FUNCTIONS ====================
+	// refer to cpp files for more detailed explanation
+	CoverageMap() {}
+	CoverageMap(int width, int height);
+	void setTile(int row, int col, bool isLawn, bool isMowed);
+	int countMowedInRow(int row) const;
+	int countMowedInRegion(int rowMin, int colMin, int rowMax, int colMax) const;
+	int countLawnInRegion(int rowMin, int colMin, int rowMax, int colMax) const;
+	bool findFirstUnmowed(int fromRow, int fromCol, int& row, int& col) const;
+	void restore(const Snapshot& snapshot);
+	int countMowedSince(const Snapshot& snapshot) const;
+
+	// getters
+	bool isMowed(int row, int col) const {
+		return (mowed[row * wordsPerRow + col / WORD_BITS] >> (col % WORD_BITS)) & 1;
+	}
+
+	bool isLawn(int row, int col) const {
+		return (lawn[row * wordsPerRow + col / WORD_BITS] >> (col % WORD_BITS)) & 1;
+	}
+
+	int countMowed() const {
+		return mowedCount;
+	}
+
+	int countLawn() const {
+		return lawnCount;
+	}
+
+	// fraction of the lawn that is mowed, 0 to 1
+	float getCoverage() const {
+		return lawnCount > 0 ? (float)mowedCount / lawnCount : 1.f;
+	}
+
+	// copies the mowed bits, a snapshot is width * height / 8 bytes
+	Snapshot snapshot() const {
+		return mowed;
+	}
+};
@@ -0,0 +1,252 @@
+#include "CoveragePlanner.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include "DistanceField.h"
+#include "TileMap.h"
+
+/*
+	Constructor
+	parameters:
+		tileMap		- the map to cover, must outlive the planner
+*/
+CoveragePlanner::CoveragePlanner(const TileMap* tileMap)
+	: tileMap(tileMap),
+	pathFinder(tileMap)
+{
+	pathFinder.setPlanner(PathPlanner::ASTAR);
+}
+
+/*
+	splits the open tiles of the map into cells, one row at a time: a span of the row continues
+	the cell of the span above it when it overlaps only that span and that span overlaps only it,
+	any other span starts a new cell (the lawn splits around an obstacle or merges below it)
+*/
+void CoveragePlanner::decompose()
+{
+	cells.clear();
+	std::vector<Span> above, current;
+	std::vector<int> aboveCells, currentCells;					// cell of each span
+	std::vector<int> aboveOverlaps;								// spans of the current row each span above overlaps
+	for (int row = 0; row < tileMap->getHeight(); row++) {
+		current.clear();
+		for (int col = 0; col < tileMap->getWidth(); col++) {
+			if (tileMap->isSolid(row, col))
+				continue;
+			if (!current.empty() && current.back().lastCol == col - 1)
+				current.back().lastCol = col;
+			else
+				current.push_back(Span{ row, col, col });
+		}
+
+		aboveOverlaps.assign(above.size(), 0);
+		for (unsigned int i = 0; i < current.size(); i++) {
+			for (unsigned int j = 0; j < above.size(); j++) {
+				if (above[j].firstCol <= current[i].lastCol && current[i].firstCol <= above[j].lastCol)
+					aboveOverlaps[j]++;
+			}
+		}
+		currentCells.assign(current.size(), -1);
+		for (unsigned int i = 0; i < current.size(); i++) {
+			int overlaps = 0, overlapped = -1;
+			for (unsigned int j = 0; j < above.size(); j++) {
+				if (above[j].firstCol <= current[i].lastCol && current[i].firstCol <= above[j].lastCol) {
+					overlaps++;
+					overlapped = j;
+				}
+			}
+			if (overlaps == 1 && aboveOverlaps[overlapped] == 1) {
+				currentCells[i] = aboveCells[overlapped];
+			}
+			else {
+				currentCells[i] = (int)cells.size();
+				cells.push_back(Cell{ std::vector<Span>(), false });
+			}
+			cells[currentCells[i]].spans.push_back(current[i]);
+		}
+		above.swap(current);
+		aboveCells.swap(currentCells);
+	}
+}
+
+/*
+	flood fills the open tiles that can be reached from the start, cells out of reach are left out of the route
+*/
+void CoveragePlanner::findReachable(glm::vec2 start)
+{
+	static const int steps[4][2] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } };
+	reachable.assign(tileMap->getWidth() * tileMap->getHeight(), 0);
+	std::vector<glm::vec2> stack;
+	stack.push_back(start);
+	reachable[tileMap->tileIndex((int)start.y, (int)start.x)] = 1;
+	while (!stack.empty()) {
+		glm::vec2 tile = stack.back();
+		stack.pop_back();
+		for (int i = 0; i < 4; i++) {
+			int col = (int)tile.x + steps[i][0], row = (int)tile.y + steps[i][1];
+			if (!tileMap->validMapPosition(col, row) || tileMap->isSolid(row, col)
+				|| reachable[tileMap->tileIndex(row, col)])
+				continue;
+			reachable[tileMap->tileIndex(row, col)] = 1;
+			stack.push_back(glm::vec2(col, row));
+		}
+	}
+}
+
+/*
+	adds the tiles on the straight line from the end of the route to a tile in the same row or column
+*/
+void CoveragePlanner::appendLine(std::vector<glm::vec2>& route, glm::vec2 to)
+{
+	glm::vec2 tile = route.back();
+	while (tile.x != to.x) {
+		tile.x += to.x > tile.x ? 1.f : -1.f;
+		route.push_back(tile);
+	}
+	while (tile.y != to.y) {
+		tile.y += to.y > tile.y ? 1.f : -1.f;
+		route.push_back(tile);
+	}
+}
+
+/*
+	adds the shortest path from the end of the route to a tile
+	returns false if the tile can't be reached, the route is left as it was
+*/
+bool CoveragePlanner::appendPath(std::vector<glm::vec2>& route, glm::vec2 to)
+{
+	if (route.back() == to)
+		return true;
+	std::vector<glm::vec2> link;
+	if (!pathFinder.findPath(route.back(), to, link))
+		return false;
+	route.insert(route.end(), link.begin() + 1, link.end());
+	linkTiles += (int)link.size() - 1;
+	return true;
+}
+
+/*
+	adds the back and forth sweep of a cell to the route, the route must end on the corner the sweep starts at
+	parameters:
+		cell		- the cell
+		fromTop		- sweep the spans top to bottom, or bottom to top
+		fromLeft	- the first span is swept left to right, or right to left
+		route		- the route so far
+*/
+void CoveragePlanner::coverCell(const Cell& cell, bool fromTop, bool fromLeft, std::vector<glm::vec2>& route)
+{
+	int count = (int)cell.spans.size();
+	bool leftToRight = fromLeft;
+	for (int k = 0; k < count; k++) {
+		const Span& span = cell.spans[fromTop ? k : count - 1 - k];
+		int entryCol = leftToRight ? span.firstCol : span.lastCol;
+		int exitCol = leftToRight ? span.lastCol : span.firstCol;
+		if (k > 0) {
+			// the spans overlap, step over to this row at the column of the overlap closest to the end of the last one
+			int col = std::min(std::max((int)route.back().x, span.firstCol), span.lastCol);
+			appendLine(route, glm::vec2(col, route.back().y));
+			appendLine(route, glm::vec2(col, span.row));
+			appendLine(route, glm::vec2(entryCol, span.row));
+		}
+		appendLine(route, glm::vec2(exitCol, span.row));
+		leftToRight = !leftToRight;
+	}
+}
+
+/*
+	Plans the route covering every open tile that can be reached from the start.
+	parameters:
+		start	- tile the robot starts on (x is the column, y the row)
+		route	- set to the tiles to go through, one per step, starting with start
+	returns false if the start isn't an open tile of the map, route is then left empty
+*/
+bool CoveragePlanner::plan(glm::vec2 start, std::vector<glm::vec2>& route)
+{
+	route.clear();
+	coveredCells = 0;
+	linkTiles = 0;
+	if (!tileMap->validMapPosition(start) || tileMap->isSolid((int)start.y, (int)start.x))
+		return false;
+	decompose();
+	findReachable(start);
+	for (unsigned int i = 0; i < cells.size(); i++) {
+		const Span& span = cells[i].spans.front();
+		cells[i].visited = !reachable[tileMap->tileIndex(span.row, span.firstCol)];
+	}
+	route.push_back(start);
+
+	while (true) {
+		// closest corner of a cell not visited yet
+		int bestCell = -1, bestDistance = INT_MAX;
+		bool bestFromTop = true, bestFromLeft = true;
+		glm::vec2 here = route.back();
+		for (unsigned int i = 0; i < cells.size(); i++) {
+			if (cells[i].visited)
+				continue;
+			for (int corner = 0; corner < 4; corner++) {
+				bool fromTop = corner < 2, fromLeft = corner % 2 == 0;
+				const Span& span = fromTop ? cells[i].spans.front() : cells[i].spans.back();
+				int col = fromLeft ? span.firstCol : span.lastCol;
+				int distance = abs(col - (int)here.x) + abs(span.row - (int)here.y);
+				if (distance < bestDistance) {
+					bestCell = i;
+					bestDistance = distance;
+					bestFromTop = fromTop;
+					bestFromLeft = fromLeft;
+				}
+			}
+		}
+		if (bestCell == -1)
+			break;
+		Cell& cell = cells[bestCell];
+		cell.visited = true;
+		const Span& entrySpan = bestFromTop ? cell.spans.front() : cell.spans.back();
+		glm::vec2 entry(bestFromLeft ? entrySpan.firstCol : entrySpan.lastCol, entrySpan.row);
+		if (!appendPath(route, entry))
+			continue;											// can't happen, the cell is reachable
+		coverCell(cell, bestFromTop, bestFromLeft, route);
+		coveredCells++;
+	}
+	return true;
+}
+
+/*
+	Splits a route into legs the battery lasts for, every leg but the last ends on a tile the robot
+	can still get to a charger from, and the next one starts with a full battery on the charger nearest
+	to it (see TileMap::getChargerDistances), coming back to the tile after. Each leg is made as long as
+	it can be: its last tile is the last one from which going to the charger still fits in the battery.
+	parameters:
+		route			- the route, see plan
+		tilesPerCharge	- tiles the robot moves on a full battery, less what it should keep in reserve
+		legEnds			- set to the route index of the last tile of every leg but the last
+	returns the number of legs. A stretch of the route too far from any charger is left to
+	the robot's own charging when the battery runs out, from there on the route isn't split.
+*/
+int CoveragePlanner::splitLegs(const std::vector<glm::vec2>& route, int tilesPerCharge, std::vector<int>& legEnds) const
+{
+	legEnds.clear();
+	const DistanceField& chargerDistances = tileMap->getChargerDistances();
+	int last = (int)route.size() - 1;
+	int legStart = 0;
+	int approach = 0;												// tiles from the charger to the start of the leg
+	while (approach + (last - legStart) > tilesPerCharge) {		// the battery doesn't last to the end of the route
+		int legEnd = -1;
+		double bestOverhead = 0;
+		for (int i = legStart; i <= last && approach + (i - legStart) <= tilesPerCharge; i++) {
+			int distance = chargerDistances.getDistance((int)route[i].y, (int)route[i].x);
+			if (distance < 0 || approach + (i - legStart) + distance > tilesPerCharge)
+				continue;
+			double overhead = (double)(approach + 2 * distance + 1) / (i - legStart + 1);
+			if (legEnd == -1 || overhead <= bestOverhead) {
+				legEnd = i;
+				bestOverhead = overhead;
+			}
+		}
+		if (legEnd == -1)
+			break;
+		legEnds.push_back(legEnd);
+		approach = chargerDistances.getDistance((int)route[legEnd].y, (int)route[legEnd].x) + 1;
+		legStart = legEnd + 1;
+	}
+	return (int)legEnds.size() + 1;
+}
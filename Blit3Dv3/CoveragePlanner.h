@@ -0,0 +1,68 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "PathFinder.h"
+
+class TileMap;
+
+/*
+	Plans one route over every open tile of a map reachable from the start, so the robot can mow
+	the lawn along it (see Robot::setCoverageRoute) instead of finding out where the obstacles are
+	by running into them.
+	The open tiles are split into boustrophedon cells: every row is cut into spans of open tiles
+	between solid ones, and a span joins the cell of the span above it if they overlap and neither
+	of them overlaps another span. A cell is then covered going back and forth along its spans, row
+	after row, without running into anything. The cells are visited in nearest neighbour order, each
+	from the corner closest (Manhattan distance) to where the previous one ended, with an A* path
+	in between. The route is one waypoint per tile, moving up, down, left and right.
+	The route can then be split into legs the battery lasts for (see splitLegs), so the robot
+	goes charging from where it's cheap to instead of wherever the battery runs out.
+	Reference used:
+		Choset, H. (2000). Coverage of Known Spaces: The Boustrophedon Cellular Decomposition. Autonomous Robots, 9(3).
+*/
+class CoveragePlanner
+{
+private:
+	// open tiles from firstCol to lastCol of a row
+	struct Span {
+		int row;
+		int firstCol;
+		int lastCol;
+	};
+	// spans of consecutive rows, top to bottom
+	struct Cell {
+		std::vector<Span> spans;
+		bool visited;
+	};
+	// =========== DATA MEMBERS ==============
+	const TileMap* tileMap;						// the map, not owned
+	PathFinder pathFinder;						// links the cells, A*
+	std::vector<Cell> cells;
+	std::vector<unsigned char> reachable;		// per tile, 1 if it can be reached from the start
+	int coveredCells = 0;						// cells on the last route, the others can't be reached from the start
+	int linkTiles = 0;							// waypoints of the last route spent going from a cell to the next
+	void decompose();
+	void findReachable(glm::vec2 start);
+	void appendLine(std::vector<glm::vec2>& route, glm::vec2 to);
+	bool appendPath(std::vector<glm::vec2>& route, glm::vec2 to);
+	void coverCell(const Cell& cell, bool fromTop, bool fromLeft, std::vector<glm::vec2>& route);
+public:
+	// =========== FUNCTIONS ====================
+	// refer to cpp files for more detailed explanation
+	CoveragePlanner(const TileMap* tileMap);
+	bool plan(glm::vec2 start, std::vector<glm::vec2>& route);
+	int splitLegs(const std::vector<glm::vec2>& route, int tilesPerCharge, std::vector<int>& legEnds) const;
+
+	// getters
+	int getCellCount() const {
+		return (int)cells.size();
+	}
+
+	int getCoveredCells() const {
+		return coveredCells;
+	}
+
+	int getLinkTiles() const {
+		return linkTiles;
+	}
+};
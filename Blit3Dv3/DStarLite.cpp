@@ -0,0 +1,304 @@
+#include "DStarLite.h"
+#include <algorithm>
+#include <cstdlib>
+#include "TileMap.h"
+
+const int DStarLite::INFINITE_COST;							// bound to const references by std::vector::assign
+
+/*
+	Constructor, the buffers are sized on the first query
+*/
+DStarLite::DStarLite(const TileMap* tileMap)
+	: tileMap(tileMap)
+{
+}
+
+/*
+	true if key a comes before key b, comparing k1 then k2
+*/
+bool DStarLite::lessKey(const OpenNode& a, const OpenNode& b)
+{
+	return a.k1 < b.k1 || (a.k1 == b.k1 && a.k2 < b.k2);
+}
+
+/*
+	orders the open list, the heap's top is the node with the smallest key
+*/
+bool DStarLite::worseNode(const OpenNode& a, const OpenNode& b)
+{
+	return lessKey(b, a);
+}
+
+/*
+	returns true if the robot can be on the tile
+*/
+bool DStarLite::walkable(int col, int row) const
+{
+	return tileMap->validMapPosition(col, row) && !tileMap->isSolid(row, col);
+}
+
+/*
+	returns true if the tile is part of the graph searched: open tiles, and the start even if it's solid
+	(the robot can overlap the corner of an obstacle, PathFinder searches from such a start too)
+*/
+bool DStarLite::inGraph(int col, int row) const
+{
+	return walkable(col, row) || row * width + col == lastStart;
+}
+
+/*
+	gets the tiles the robot can move to from a tile, like PathFinder::getNeighbours,
+	a tile out of the graph has none, moves go both ways so these are also the tiles that can move to it
+	returns the number of neighbours
+*/
+int DStarLite::getNeighbours(int index, int neighbours[], int costs[]) const
+{
+	static const int steps[8][2] = {
+		{ 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 },			// up, down, left, right
+		{ -1, -1 }, { 1, -1 }, { -1, 1 }, { 1, 1 }			// the diagonals
+	};
+	int col = index % width, row = index / width;
+	if (!inGraph(col, row))
+		return 0;
+	int count = 0;
+	for (int i = 0; i < (allowDiagonal ? 8 : 4); i++) {
+		int nextCol = col + steps[i][0], nextRow = row + steps[i][1];
+		if (!tileMap->validMapPosition(nextCol, nextRow) || !inGraph(nextCol, nextRow))
+			continue;
+		if (i >= 4 && (!walkable(nextCol, row) || !walkable(col, nextRow)))
+			continue;											// would clip the corner of a solid tile
+		neighbours[count] = nextRow * width + nextCol;
+		costs[count++] = i < 4 ? STRAIGHT_COST : DIAGONAL_COST;
+	}
+	return count;
+}
+
+/*
+	estimated cost between two tiles, never more than the real cost:
+	Manhattan distance for straight moves only, octile distance with diagonal moves
+*/
+int DStarLite::heuristic(int from, int to) const
+{
+	int dx = abs(from % width - to % width);
+	int dy = abs(from / width - to / width);
+	if (!allowDiagonal)
+		return STRAIGHT_COST * (dx + dy);
+	return STRAIGHT_COST * (dx + dy) + (DIAGONAL_COST - 2 * STRAIGHT_COST) * std::min(dx, dy);
+}
+
+/*
+	gives a tile infinite costs if it hasn't been reached since the search started over
+*/
+void DStarLite::touch(int index)
+{
+	if (stamp[index] == generation)
+		return;
+	stamp[index] = generation;
+	g[index] = INFINITE_COST;
+	rhs[index] = INFINITE_COST;
+	queued[index] = 0;
+}
+
+/*
+	the key a tile goes in the open list with
+*/
+DStarLite::OpenNode DStarLite::calculateKey(int index) const
+{
+	int cost = std::min(g[index], rhs[index]);
+	OpenNode key = { cost + heuristic(lastStart, index) + keyModifier, cost, index };
+	return key;
+}
+
+/*
+	recomputes the cost of a tile through its best neighbour and puts it in the open list
+	if that doesn't match its cost as of its last expansion
+*/
+void DStarLite::updateVertex(int index)
+{
+	touch(index);
+	if (index != goal) {
+		int neighbours[8], costs[8];
+		int count = getNeighbours(index, neighbours, costs);
+		rhs[index] = INFINITE_COST;
+		for (int i = 0; i < count; i++) {
+			touch(neighbours[i]);
+			rhs[index] = std::min(rhs[index], costs[i] + g[neighbours[i]]);
+		}
+	}
+	queued[index] = 0;											// its old entry, if any, is now stale
+	if (g[index] != rhs[index]) {
+		queued[index] = generation;
+		queuedKey[index] = calculateKey(index);
+		open.push_back(queuedKey[index]);
+		std::push_heap(open.begin(), open.end(), worseNode);
+	}
+}
+
+/*
+	updates a tile that turned solid or open and its 8 neighbours, every move that changed
+	starts or ends on one of them (a diagonal move clipping the tile's corner included)
+*/
+void DStarLite::updateNeighbourhood(int index)
+{
+	int col = index % width, row = index / width;
+	for (int dy = -1; dy <= 1; dy++) {
+		for (int dx = -1; dx <= 1; dx++) {
+			if (tileMap->validMapPosition(col + dx, row + dy))
+				updateVertex((row + dy) * width + col + dx);
+		}
+	}
+}
+
+/*
+	gets the smallest key of the open list, dropping the stale entries on top
+	returns false if the open list is empty
+*/
+bool DStarLite::topKey(OpenNode& key)
+{
+	while (!open.empty()) {
+		const OpenNode& top = open.front();
+		if (queued[top.index] == generation && queuedKey[top.index].k1 == top.k1 && queuedKey[top.index].k2 == top.k2) {
+			key = top;
+			return true;
+		}
+		std::pop_heap(open.begin(), open.end(), worseNode);
+		open.pop_back();
+	}
+	return false;
+}
+
+/*
+	forgets all costs and starts a search from a new goal
+*/
+void DStarLite::initialize(int goalIndex)
+{
+	int tileCount = tileMap->getWidth() * tileMap->getHeight();
+	if (width != tileMap->getWidth() || height != tileMap->getHeight() || (int)stamp.size() != tileCount) {
+		width = tileMap->getWidth();
+		height = tileMap->getHeight();
+		stamp.assign(tileCount, 0);
+		g.assign(tileCount, INFINITE_COST);
+		rhs.assign(tileCount, INFINITE_COST);
+		queued.assign(tileCount, 0);
+		queuedKey.resize(tileCount);
+		generation = 0;
+	}
+	generation++;
+	if (generation == 0) {		// wrapped around, old stamps could match again
+		stamp.assign(tileCount, 0);
+		queued.assign(tileCount, 0);
+		generation = 1;
+	}
+	open.clear();
+	goal = goalIndex;
+	keyModifier = 0;
+	touch(goal);
+	rhs[goal] = 0;
+	updateVertex(goal);
+	syncedEdits = (unsigned int)tileMap->getSolidEdits().size();
+	initialized = true;
+}
+
+/*
+	expands tiles until the cost of the start is known, only the tiles whose cost changed
+	and could be on the shortest path from the start get expanded
+*/
+void DStarLite::computeShortestPath(int startIndex)
+{
+	int neighbours[8], costs[8];
+	OpenNode top;
+	while (topKey(top)) {
+		touch(startIndex);
+		if (!lessKey(top, calculateKey(startIndex)) && rhs[startIndex] == g[startIndex])
+			break;
+		std::pop_heap(open.begin(), open.end(), worseNode);
+		open.pop_back();
+		int index = top.index;
+		queued[index] = 0;
+		expandedTiles++;
+		OpenNode newKey = calculateKey(index);
+		if (lessKey(top, newKey)) {								// the start moved since it was queued, requeue
+			queued[index] = generation;
+			queuedKey[index] = newKey;
+			open.push_back(newKey);
+			std::push_heap(open.begin(), open.end(), worseNode);
+		}
+		else if (g[index] > rhs[index]) {						// got cheaper, settle it and tell the neighbours
+			g[index] = rhs[index];
+			int count = getNeighbours(index, neighbours, costs);
+			for (int i = 0; i < count; i++)
+				updateVertex(neighbours[i]);
+		}
+		else {													// got more expensive, redo it and its neighbours
+			g[index] = INFINITE_COST;
+			updateVertex(index);
+			int count = getNeighbours(index, neighbours, costs);
+			for (int i = 0; i < count; i++)
+				updateVertex(neighbours[i]);
+		}
+	}
+}
+
+/*
+	Finds the shortest path from start to goal. Asking for the same goal again, from wherever the
+	robot is now, reuses the costs of the previous query and repairs them around the tiles edited since.
+	parameters:
+		startIndex, goalIndex	- tile indices
+		path					- set to the tiles from start to goal, both included
+	returns false if the goal is unreachable, path is then left empty
+*/
+bool DStarLite::findPath(int startIndex, int goalIndex, std::vector<glm::vec2>& path)
+{
+	path.clear();
+	expandedTiles = 0;
+	const std::vector<int>& edits = tileMap->getSolidEdits();
+	bool sameMap = width == tileMap->getWidth() && height == tileMap->getHeight() && edits.size() >= syncedEdits;
+	if (!initialized || goalIndex != goal || !sameMap) {
+		lastStart = startIndex;
+		initialize(goalIndex);
+	}
+	else {
+		if (startIndex != lastStart) {							// keys already queued stay lower bounds
+			int previousStart = lastStart;
+			keyModifier += heuristic(lastStart, startIndex);
+			lastStart = startIndex;
+			// a solid start is only in the graph while it's the start
+			if (!walkable(previousStart % width, previousStart / width))
+				updateNeighbourhood(previousStart);
+			if (!walkable(startIndex % width, startIndex / width))
+				updateNeighbourhood(startIndex);
+		}
+		for (unsigned int i = syncedEdits; i < edits.size(); i++)
+			updateNeighbourhood(edits[i]);
+		syncedEdits = (unsigned int)edits.size();
+	}
+	if (!walkable(goalIndex % width, goalIndex / width))
+		return false;
+	computeShortestPath(startIndex);
+	touch(startIndex);
+	if (g[startIndex] >= INFINITE_COST)
+		return false;
+
+	// go down the costs from the start, a step at a time
+	int neighbours[8], costs[8];
+	int index = startIndex;
+	path.push_back(glm::vec2(index % width, index / width));
+	while (index != goal) {
+		int count = getNeighbours(index, neighbours, costs);
+		int next = -1, nextCost = INFINITE_COST;
+		for (int i = 0; i < count; i++) {
+			touch(neighbours[i]);
+			if (costs[i] + g[neighbours[i]] < nextCost) {
+				nextCost = costs[i] + g[neighbours[i]];
+				next = neighbours[i];
+			}
+		}
+		if (next == -1 || path.size() > stamp.size()) {		// can't happen with consistent costs
+			path.clear();
+			return false;
+		}
+		index = next;
+		path.push_back(glm::vec2(index % width, index / width));
+	}
+	return true;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+class TileMap;
+
+/*
+	Incremental path finding with D* Lite, for maps whose obstacles change while the robot drives.
+	The search runs backward from the goal and keeps its costs between queries, so asking again
+	for the same goal after tiles turned solid or open (TileMap::setTile) only reprocesses the tiles
+	whose cost to the goal changed, and the robot can be anywhere on the map by then.
+	A query for another goal starts over, costing about the same as an A* search.
+	Moves are up, down, left and right, and diagonally too if allowed, never cutting the corner of a solid tile.
+	Reference used:
+		Koenig, S., Likhachev, M. (2002). D* Lite. Proceedings of the AAAI Conference on Artificial Intelligence.
+*/
+class DStarLite
+{
+private:
+	// an entry of the open list, entries whose key isn't the tile's queued key anymore are skipped
+	struct OpenNode {
+		int k1;									// min(g, rhs) + heuristic to the start + keyModifier
+		int k2;									// min(g, rhs)
+		int index;
+	};
+	static const int STRAIGHT_COST = 10;		// same step costs as PathFinder
+	static const int DIAGONAL_COST = 14;
+	static const int INFINITE_COST = 0x3FFFFFFF;
+	// =========== DATA MEMBERS ==============
+	const TileMap* tileMap;						// the map, not owned
+	bool allowDiagonal = false;
+	bool initialized = false;					// the costs belong to goal and the map up to syncedEdits
+	int width = 0, height = 0;
+	int goal = -1;								// tile index of the goal of the costs
+	int lastStart = -1;							// start the keys in the open list are relative to
+	int keyModifier = 0;						// km of the paper, heuristic distance the start moved since the search began
+	unsigned int syncedEdits = 0;				// edits of the map (TileMap::getSolidEdits) already applied
+	unsigned int generation = 0;				// tiles stamped with an older generation have infinite costs
+	std::vector<unsigned int> stamp;
+	std::vector<int> g;							// cost to the goal as of the last expansion of the tile
+	std::vector<int> rhs;						// cost to the goal through the best neighbour
+	std::vector<unsigned int> queued;			// generation the tile is in the open list in, 0 if it isn't
+	std::vector<OpenNode> queuedKey;			// key the tile is in the open list with
+	std::vector<OpenNode> open;					// open list, a binary heap
+	int expandedTiles = 0;						// tiles expanded by the last query
+	static bool worseNode(const OpenNode& a, const OpenNode& b);
+	static bool lessKey(const OpenNode& a, const OpenNode& b);
+	bool walkable(int col, int row) const;
+	bool inGraph(int col, int row) const;
+	int getNeighbours(int index, int neighbours[], int costs[]) const;
+	int heuristic(int from, int to) const;
+	void touch(int index);
+	OpenNode calculateKey(int index) const;
+	void updateVertex(int index);
+	void updateNeighbourhood(int index);
+	bool topKey(OpenNode& key);
+	void initialize(int goalIndex);
+	void computeShortestPath(int startIndex);
+public:
+	// =========== FUNCTIONS ====================
+	// refer to cpp files for more detailed explanation
+	DStarLite(const TileMap* tileMap);
+	bool findPath(int startIndex, int goalIndex, std::vector<glm::vec2>& path);
+
+	// getters and setters
+	void setAllowDiagonal(bool allowDiagonal) {
+		if (this->allowDiagonal != allowDiagonal)
+			initialized = false;
+		this->allowDiagonal = allowDiagonal;
+	}
+
+	int getExpandedTiles() const {
+		return expandedTiles;
+	}
+};
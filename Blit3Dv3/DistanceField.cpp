@@ -0,0 +1,217 @@
+#include "DistanceField.h"
+#include <algorithm>
+#include "Tileset.h"
+
+// column and row offsets of the neighbours of a tile: up, down, left, right
+static const int offsets[4][2] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } };
+
+/*
+	Constructor, a field of the given size in tiles where nothing reaches a charger yet
+*/
+DistanceField::DistanceField(int width, int height)
+	: width(width), height(height)
+{
+	distance = std::vector<int>(width * height, -1);
+	raised = std::vector<unsigned char>(width * height, 0);
+	queue.reserve(width * height);
+}
+
+/*
+	true if the robot can drive over a tile with these flags
+*/
+bool DistanceField::isOpen(unsigned char flags)
+{
+	return !(flags & TILE_SOLID);
+}
+
+/*
+	true if a tile with these flags is a charger the robot can drive onto
+*/
+bool DistanceField::isSource(unsigned char flags)
+{
+	return (flags & TILE_CHARGING) && isOpen(flags);
+}
+
+/*
+	expands the queued tiles, giving each open neighbour the distance
+	of the tile plus one when that is shorter than what it had, until no distance changes
+	the queue is in order of distance so every tile ends up with its shortest distance
+*/
+void DistanceField::propagate(const std::vector<unsigned char>& tileFlags)
+{
+	unsigned int head = 0;
+	while (head < queue.size()) {
+		int index = queue[head++];
+		int row = index / width, col = index % width;
+		for (int i = 0; i < 4; i++) {
+			int nextCol = col + offsets[i][0], nextRow = row + offsets[i][1];
+			if (nextCol < 0 || nextRow < 0 || nextCol >= width || nextRow >= height)
+				continue;
+			int next = nextRow * width + nextCol;
+			if (!isOpen(tileFlags[next]))
+				continue;
+			if (distance[next] != -1 && distance[next] <= distance[index] + 1)
+				continue;
+			distance[next] = distance[index] + 1;
+			queue.push_back(next);
+		}
+	}
+	queue.clear();
+}
+
+/*
+	computes the distances of every tile from scratch
+	parameters:
+		tileFlags	- flags of the tiles of the map (see TileFlag), width * height of them
+*/
+void DistanceField::build(const std::vector<unsigned char>& tileFlags)
+{
+	queue.clear();
+	for (unsigned int i = 0; i < distance.size(); i++) {
+		distance[i] = isSource(tileFlags[i]) ? 0 : -1;
+		if (distance[i] == 0)
+			queue.push_back(i);
+	}
+	propagate(tileFlags);
+	rebuilds++;
+}
+
+/*
+	repairs the distances after a tile closed or stopped being a charger, only the tiles whose every
+	shortest way to a charger went through it are recomputed: first they're found going outward
+	from the tile (a tile is cut off when none of its neighbours one step closer keeps its distance),
+	then they get their distances again from the tiles around them, like after opening a tile
+*/
+void DistanceField::raise(const std::vector<unsigned char>& tileFlags, int index)
+{
+	queue.clear();
+	if (distance[index] == -1)							// nothing went through it
+		return;
+	raised[index] = 1;
+	queue.push_back(index);
+	// the queue is in order of distance, so all the cut off tiles one step closer than a tile
+	// are known by the time the tile is looked at
+	for (unsigned int head = 0; head < queue.size(); head++) {
+		int row = queue[head] / width, col = queue[head] % width;
+		for (int i = 0; i < 4; i++) {
+			int nextCol = col + offsets[i][0], nextRow = row + offsets[i][1];
+			if (nextCol < 0 || nextRow < 0 || nextCol >= width || nextRow >= height)
+				continue;
+			int next = nextRow * width + nextCol;
+			if (raised[next] || distance[next] != distance[queue[head]] + 1)
+				continue;
+			bool supported = false;
+			for (int j = 0; j < 4 && !supported; j++) {
+				int supportCol = nextCol + offsets[j][0], supportRow = nextRow + offsets[j][1];
+				if (supportCol < 0 || supportRow < 0 || supportCol >= width || supportRow >= height)
+					continue;
+				int support = supportRow * width + supportCol;
+				supported = !raised[support] && distance[support] == distance[next] - 1;
+			}
+			if (!supported) {
+				raised[next] = 1;
+				queue.push_back(next);
+			}
+		}
+	}
+
+	// the tiles around the cut off ones are where the distances come back from
+	seeds.clear();
+	for (unsigned int i = 0; i < queue.size(); i++)
+		distance[queue[i]] = -1;
+	for (unsigned int i = 0; i < queue.size(); i++) {
+		int row = queue[i] / width, col = queue[i] % width;
+		if (isSource(tileFlags[queue[i]])) {
+			distance[queue[i]] = 0;
+			seeds.push_back(queue[i]);
+		}
+		for (int j = 0; j < 4; j++) {
+			int nextCol = col + offsets[j][0], nextRow = row + offsets[j][1];
+			if (nextCol < 0 || nextRow < 0 || nextCol >= width || nextRow >= height)
+				continue;
+			int next = nextRow * width + nextCol;
+			if (!raised[next] && distance[next] != -1)
+				seeds.push_back(next);
+		}
+	}
+	for (unsigned int i = 0; i < queue.size(); i++)
+		raised[queue[i]] = 0;
+	// closest first, so most tiles get their final distance the first time
+	std::sort(seeds.begin(), seeds.end(), [this](int a, int b) {
+		return distance[a] < distance[b] || (distance[a] == distance[b] && a < b);
+	});
+	seeds.erase(std::unique(seeds.begin(), seeds.end()), seeds.end());
+	queue.assign(seeds.begin(), seeds.end());
+	propagate(tileFlags);
+}
+
+/*
+	updates the distances after a tile changed, called by the TileMap when a tile
+	turned solid or open, or became or stopped being a charger
+	parameters:
+		tileFlags		- flags of the tiles of the map, the changed tile already updated
+		index			- the tile that changed
+		previousFlags	- flags of the tile before the change
+*/
+void DistanceField::update(const std::vector<unsigned char>& tileFlags, int index, unsigned char previousFlags)
+{
+	unsigned char flags = tileFlags[index];
+	if ((isOpen(previousFlags) && !isOpen(flags)) || (isSource(previousFlags) && !isSource(flags))) {
+		// paths through the tile are gone, distances behind it may grow
+		raise(tileFlags, index);
+		return;
+	}
+	if (!isOpen(flags))
+		return;
+	// the tile opened or became a charger, distances around it can only get shorter
+	int row = index / width, col = index % width;
+	if (isSource(flags)) {
+		distance[index] = 0;
+	}
+	else {
+		distance[index] = -1;
+		for (int i = 0; i < 4; i++) {
+			int nextCol = col + offsets[i][0], nextRow = row + offsets[i][1];
+			if (nextCol < 0 || nextRow < 0 || nextCol >= width || nextRow >= height)
+				continue;
+			int neighbourDistance = distance[nextRow * width + nextCol];
+			if (neighbourDistance != -1 && (distance[index] == -1 || neighbourDistance + 1 < distance[index]))
+				distance[index] = neighbourDistance + 1;
+		}
+		if (distance[index] == -1)						// walled in or cut off from every charger
+			return;
+	}
+	queue.clear();
+	queue.push_back(index);
+	propagate(tileFlags);
+}
+
+/*
+	walks down the field from a tile to the nearest charger
+	parameters:
+		row, col	- the starting tile
+		path		- set to the tiles to step through, not including the starting tile,
+					  one tile per step like PathFinder's paths (x is the column, y the row)
+	returns false if no charger can be reached from the tile
+*/
+bool DistanceField::descend(int row, int col, std::vector<glm::vec2>& path) const
+{
+	path.clear();
+	if (row < 0 || col < 0 || row >= height || col >= width || distance[row * width + col] == -1)
+		return false;
+	while (distance[row * width + col] > 0) {
+		int current = distance[row * width + col];
+		for (int i = 0; i < 4; i++) {
+			int nextCol = col + offsets[i][0], nextRow = row + offsets[i][1];
+			if (nextCol < 0 || nextRow < 0 || nextCol >= width || nextRow >= height)
+				continue;
+			if (distance[nextRow * width + nextCol] == current - 1) {	// a step closer, there always is one
+				col = nextCol;
+				row = nextRow;
+				break;
+			}
+		}
+		path.push_back(glm::vec2(col, row));
+	}
+	return true;
+}
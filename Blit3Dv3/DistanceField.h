@@ -0,0 +1,47 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+/*
+	Distance in tiles from every tile of a map to the nearest charging station,
+	moving up, down, left and right around solid tiles.
+	Built with one breadth-first search started from all the charging tiles at once,
+	so a robot anywhere on the map finds its way to the closest charger by stepping
+	to a neighbour one tile closer until it gets there (see descend), without searching.
+	The TileMap owns one and updates it when tiles are edited: opening a tile or adding a charger
+	only shortens distances and is repaired from that tile, closing one only redoes the tiles
+	that were reaching a charger through it.
+*/
+class DistanceField
+{
+private:
+	// =========== DATA MEMBERS ==============
+	int width = 0;
+	int height = 0;
+	std::vector<int> distance;					// per tile, steps to the nearest charger, -1 if solid or cut off
+	std::vector<int> queue;						// tiles to expand, reused between updates
+	std::vector<int> seeds;						// tiles the distances come back from after a tile closed
+	std::vector<unsigned char> raised;			// per tile, cut off from the chargers by the tile that closed, see raise
+	int rebuilds = 0;							// number of full searches, for statistics
+	static bool isOpen(unsigned char flags);
+	static bool isSource(unsigned char flags);
+	void propagate(const std::vector<unsigned char>& tileFlags);
+	void raise(const std::vector<unsigned char>& tileFlags, int index);
+public:
+	// =========== FUNCTIONS ====================
+	// refer to cpp files for more detailed explanation
+	DistanceField(int width = 0, int height = 0);
+	void build(const std::vector<unsigned char>& tileFlags);
+	void update(const std::vector<unsigned char>& tileFlags, int index, unsigned char previousFlags);
+	bool descend(int row, int col, std::vector<glm::vec2>& path) const;
+
+	// getters and setters
+	// steps from the tile to the nearest charger, -1 if it can't reach one
+	int getDistance(int row, int col) const {
+		return distance[row * width + col];
+	}
+
+	int getRebuilds() const {
+		return rebuilds;
+	}
+};
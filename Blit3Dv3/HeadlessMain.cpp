@@ -0,0 +1,462 @@
+/*
+Console runner for the mowing simulation, runs robots on a map without a window
+as fast as the CPU allows and prints a summary of the runs.
+
+usage: mowersim [mapfile] [--tileset FILE] [--strategy bounce|zigzag|route|both|all] [--max-ticks N] [--time-slice SECONDS]
+               [--integration tick|segment] [--charge-curve FILE] [--planner bfs|astar|jps|hpa|dstar] [--diagonal]
+               [--return perimeter|field] [--resume column|path] [--path-cache N] [--obstacles FILE] [--async-planning N] [--planning-delay TICKS]
+               [--route-legs PERCENT] [--collision sampled|swept] [--kinematics float|fixed] [--bounce random|unmowed] [--bounce-candidates N]
+               [--runs N] [--threads N] [--seed N] [--stream N] [--stuck-ticks N]
+               [--record FILE] [--replay FILE] [--verify]
+
+with --runs 1 (the default) the run is printed in detail, otherwise the runs are
+spread over --threads worker threads and aggregate statistics are printed per strategy.
+--record saves the map, seed and settings of a single run with its trajectory hash,
+--replay runs a recorded run again and checks it reproduces the same trajectory bit for bit,
+--verify runs a single run twice on different threads and checks both trajectories are identical,
+--planner picks the search used for detours around obstacles, all of them find shortest paths
+except hpa which finds near optimal ones faster on big maps, --diagonal lets detours move diagonally,
+--return picks how the robot gets to a charger when out of battery: following the perimeter (the default)
+or straight down the map's distance field to the nearest one,
+--resume picks how the charged robot gets back to mowing: left to column 1 and down to the row it left (the default)
+or along the shortest path to where it left off,
+--obstacles puts obstacles on and off the map during the run, one per line: tick row col foreground (-1 takes it off),
+--path-cache keeps up to N detours found (4096 by default) for every run of the batch to reuse, 0 turns it off,
+--async-planning searches detours on N worker threads shared by the runs instead of inside the tick (0, the default),
+--planning-delay makes the robot hold TICKS ticks for every detour (0 by default), the trajectory doesn't depend
+on the threads then, -1 holds until the worker is done, which can't be replayed (meant for the windowed version,
+headless ticks are so short the robot holds hundreds of them per search),
+--strategy route mows along a route planned for the whole map at the start (see CoveragePlanner),
+--route-legs splits the route in legs the battery lasts for with PERCENT of it in reserve, the robot goes charging
+at the end of each instead of when the battery runs out,
+--collision swept sweeps the robot along each step and stops it where it touches a wall instead of checking
+where it ended up (sampled, the default), so --time-slice can go up without the robot going through thin obstacles,
+--kinematics fixed keeps the robot's position on a 256th of a pixel and takes bounce headings off a sine table, so
+a trajectory hash (sampled collisions) is the same whatever compiler and optimization the simulator was built with,
+float (the default) steps it with plain floats,
+--bounce picks how the robot turns when it bounces: 120 +- 15 degrees to a random side (the default), or the best of
+--bounce-candidates headings (8 by default) by the most unmowed tiles on the way (random again if there are none),
+--tileset describes the tile types of the map (see tileset.dat), the BOF22 sprite sheet by default
+*/
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <thread>
+#include "BatchRunner.h"
+#include "Replay.h"
+
+static void printUsage()
+{
+	std::cout << "usage: mowersim [mapfile] [--tileset FILE] [--strategy bounce|zigzag|route|both|all] [--max-ticks N] [--time-slice SECONDS]" << std::endl
+		<< "                [--integration tick|segment] [--charge-curve FILE] [--planner bfs|astar|jps|hpa|dstar] [--diagonal]" << std::endl
+		<< "                [--return perimeter|field] [--resume column|path] [--path-cache N] [--obstacles FILE] [--async-planning N] [--planning-delay TICKS]" << std::endl
+		<< "                [--route-legs PERCENT] [--collision sampled|swept] [--kinematics float|fixed] [--bounce random|unmowed] [--bounce-candidates N]" << std::endl
+		<< "                [--runs N] [--threads N] [--seed N] [--stream N] [--stuck-ticks N]" << std::endl
+		<< "                [--record FILE] [--replay FILE] [--verify]" << std::endl;
+}
+
+static const char* strategyName(UpdateStrategy strategy)
+{
+	if (strategy == UpdateStrategy::BOUNCE)
+		return "bounce";
+	return strategy == UpdateStrategy::ROUTE ? "route" : "zigzag";
+}
+
+// prints one row of the batch statistics table
+static void printStatistic(const char* name, const BatchStatistic& statistic)
+{
+	std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(2)
+		<< std::setw(14) << statistic.mean
+		<< std::setw(14) << statistic.stddev
+		<< std::setw(14) << statistic.min
+		<< std::setw(14) << statistic.max << std::endl;
+}
+
+// runs a single simulation and prints it in detail
+static SimulationResult runSingle(const std::string& mapFilename, const TileMap& tileMap,
+	const SimulationSettings& settings, long long maxTicks)
+{
+	Simulation simulation(tileMap, settings);
+
+	auto wallStart = std::chrono::steady_clock::now();
+	SimulationResult result = simulation.run(maxTicks);
+	auto wallEnd = std::chrono::steady_clock::now();
+	double wallSeconds = std::chrono::duration<double>(wallEnd - wallStart).count();
+	// the windowed version runs one tick every time slice
+	double realTimeSeconds = result.ticks * (double)settings.timeSlice;
+
+	std::cout << "map:            " << mapFilename << " (" << simulation.getTileMap().getWidth() << "x" << simulation.getTileMap().getHeight() << ")" << std::endl;
+	std::cout << "strategy:       " << strategyName(settings.strategy) << std::endl;
+	if (settings.strategy == UpdateStrategy::ROUTE) {
+		std::cout << "route:          " << result.routeLength << " tiles, " << result.routeCells << " cells, "
+			<< result.routeLegs << (result.routeLegs == 1 ? " leg" : " legs") << std::endl;
+	}
+	std::cout << "integration:    " << (settings.integrationMode == IntegrationMode::TICK ? "tick" : "segment") << std::endl;
+	std::cout << "collision:      " << (settings.collisionMode == CollisionMode::SAMPLED ? "sampled" : "swept") << std::endl;
+	std::cout << "kinematics:     " << (settings.kinematicsMode == KinematicsMode::FLOAT ? "float" : "fixed") << std::endl;
+	if (settings.seeded) {
+		std::cout << "seed:           " << settings.seed << " stream " << settings.stream << std::endl;
+	}
+	std::cout << "planner:        " << PathFinder::plannerName(settings.pathPlanner)
+		<< (settings.allowDiagonal ? " (diagonal)" : "") << std::endl;
+	if (!settings.obstacleEvents.empty()) {
+		std::cout << "obstacles:      " << settings.obstacleEvents.size() << " events" << std::endl;
+	}
+	if (settings.bounceMode != BounceMode::RANDOM) {
+		std::cout << "bounce:         " << Robot::bounceModeName(settings.bounceMode) << " of "
+			<< settings.bounceCandidates << " headings" << std::endl;
+	}
+	std::cout << "return:         " << (settings.chargerReturn == ChargerReturn::PERIMETER ? "perimeter" : "field") << std::endl;
+	std::cout << "resume:         " << (settings.resumeMode == ResumeMode::GOING_BACK ? "column" : "path") << std::endl;
+	if (settings.plannerPool || settings.planningDelay != 0) {
+		std::cout << "planning:       ";
+		if (settings.plannerPool)
+			std::cout << settings.plannerPool->getThreadCount() << " worker threads, ";
+		if (settings.planningDelay >= 0)
+			std::cout << "holds " << settings.planningDelay << " ticks per detour" << std::endl;
+		else
+			std::cout << "holds until the detour is found" << std::endl;
+	}
+	std::cout << "ticks:          " << result.ticks << std::endl;
+	std::cout << "time:           " << std::fixed << std::setprecision(4) << result.timePassed << " hrs" << std::endl;
+	std::cout << "charges:        " << result.rechargeCount << std::endl;
+	std::cout << "tiles mowed:    " << result.tilesMowed << std::endl;
+	std::cout << "tiles to mow:   " << result.tilesToMow << std::endl;
+	std::cout << "coverage:       " << std::setprecision(2) << result.coverage * 100.f << "%" << std::endl;
+	std::cout << "by quarter:     " << result.quarterCoverage[0] * 100.f << "% " << result.quarterCoverage[1] * 100.f << "% "
+		<< result.quarterCoverage[2] * 100.f << "% " << result.quarterCoverage[3] * 100.f << "% (top left, top right, bottom left, bottom right)" << std::endl;
+	if (result.firstUnmowedRow != -1) {
+		std::cout << "left to mow:    " << result.unfinishedRows << (result.unfinishedRows == 1 ? " row" : " rows")
+			<< ", first at row " << result.firstUnmowedRow << " col " << result.firstUnmowedCol << std::endl;
+	}
+	if (result.legTilesMowed.size() > 1) {
+		std::cout << "mowed by leg:  ";
+		for (unsigned int i = 0; i < result.legTilesMowed.size(); i++)
+			std::cout << " " << result.legTilesMowed[i];
+		std::cout << " tiles" << std::endl;
+	}
+	std::cout << "finished:       " << (result.finished ? "yes" : (result.stuck ? "no (stuck)" : "no")) << std::endl;
+	std::cout << "path searches:  " << result.pathSearches << " (" << result.expandedTiles << " tiles expanded";
+	if (result.pathSearches > 0) {
+		std::cout << ", " << std::setprecision(1) << (double)result.expandedTiles / result.pathSearches << " per search";
+	}
+	std::cout << ")" << std::endl;
+	if (settings.pathCache) {
+		std::cout << "path cache:     " << result.pathCacheHits << " hits, "
+			<< result.pathSearches - result.pathCacheHits << " misses" << std::endl;
+	}
+	std::cout << "wall time:      " << std::setprecision(3) << wallSeconds << " s";
+	if (wallSeconds > 0) {
+		std::cout << " (" << std::setprecision(0) << realTimeSeconds / wallSeconds << "x real-time)";
+	}
+	std::cout << std::endl;
+	std::cout << "trajectory:     " << std::hex << result.trajectoryHash << std::dec << std::endl;
+	return result;
+}
+
+// replays a recorded run and checks it reproduces the recorded trajectory
+static int runReplay(const std::string& replayFilename)
+{
+	ReplayRecord record;
+	if (!LoadReplay(replayFilename, record))
+		return -1;
+	Tileset tileset;
+	if (!record.tilesetFilename.empty() && !tileset.LoadTileset(record.tilesetFilename))
+		return -1;
+	TileMap tileMap(record.mapFilename, tileset);
+	SimulationResult result = runSingle(record.mapFilename, tileMap, record.settings, record.maxTicks);
+	if (result.ticks == record.ticks && result.trajectoryHash == record.trajectoryHash) {
+		std::cout << "replay:         match" << std::endl;
+		return 0;
+	}
+	std::cout << "replay:         MISMATCH, recorded " << record.ticks << " ticks with trajectory "
+		<< std::hex << record.trajectoryHash << std::dec << std::endl;
+	return 1;
+}
+
+// runs a batch of simulations and prints the aggregate statistics
+static void runBatch(const TileMap& tileMap, const SimulationSettings& settings,
+	long long maxTicks, int runs, unsigned int threads, unsigned int seed)
+{
+	BatchRunner batchRunner(tileMap, settings, maxTicks, threads);
+
+	auto wallStart = std::chrono::steady_clock::now();
+	std::vector<SimulationResult> results = batchRunner.run(runs, seed);
+	auto wallEnd = std::chrono::steady_clock::now();
+	double wallSeconds = std::chrono::duration<double>(wallEnd - wallStart).count();
+	BatchSummary summary = BatchRunner::summarize(results);
+
+	std::cout << "strategy " << strategyName(settings.strategy) << ": " << summary.runs << " runs on "
+		<< batchRunner.getThreadCount() << " threads in " << std::fixed << std::setprecision(3) << wallSeconds << " s" << std::endl;
+	std::cout << std::left << std::setw(16) << "" << std::right
+		<< std::setw(14) << "mean" << std::setw(14) << "stddev" << std::setw(14) << "min" << std::setw(14) << "max" << std::endl;
+	printStatistic("time (hrs)", summary.timePassed);
+	printStatistic("charges", summary.rechargeCount);
+	printStatistic("tiles mowed", summary.tilesMowed);
+	printStatistic("coverage (%)", summary.coverage);
+	printStatistic("ticks", summary.ticks);
+	std::cout << "finished: " << summary.finishedRuns << "/" << summary.runs
+		<< "  stuck: " << summary.stuckRuns << "/" << summary.runs << std::endl;
+	if (settings.pathCache) {
+		std::cout << "path cache: " << settings.pathCache->getHits() << " hits, " << settings.pathCache->getMisses()
+			<< " misses, " << settings.pathCache->getSize() << " paths kept" << std::endl;
+	}
+	std::cout << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string mapFilename = "mapfile.dat";
+	SimulationSettings settings;
+	std::vector<UpdateStrategy> strategies = { UpdateStrategy::ZIGZAG };
+	std::string chargeCurveFilename;
+	std::string tilesetFilename;
+	std::string obstaclesFilename;
+	long long maxTicks = 100000000;
+	int runs = 1;
+	unsigned int threads = 0;
+	unsigned long long seed = 0;
+	std::string recordFilename;
+	bool verify = false;
+	size_t pathCacheSize = 4096;
+	unsigned int planningThreads = 0;
+	// a robot that hasn't mowed for 10 hours of ticks is stuck
+	settings.stuckTicks = 3600000;
+
+	// parse command line arguments
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--strategy") == 0 && i + 1 < argc) {
+			std::string name = argv[++i];
+			if (name == "bounce") {
+				strategies = { UpdateStrategy::BOUNCE };
+			}
+			else if (name == "zigzag") {
+				strategies = { UpdateStrategy::ZIGZAG };
+			}
+			else if (name == "route") {
+				strategies = { UpdateStrategy::ROUTE };
+			}
+			else if (name == "both") {
+				strategies = { UpdateStrategy::BOUNCE, UpdateStrategy::ZIGZAG };
+			}
+			else if (name == "all") {
+				strategies = { UpdateStrategy::BOUNCE, UpdateStrategy::ZIGZAG, UpdateStrategy::ROUTE };
+			}
+			else {
+				printUsage();
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc) {
+			maxTicks = atoll(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--time-slice") == 0 && i + 1 < argc) {
+			settings.timeSlice = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--integration") == 0 && i + 1 < argc) {
+			std::string name = argv[++i];
+			if (name == "tick") {
+				settings.integrationMode = IntegrationMode::TICK;
+			}
+			else if (name == "segment") {
+				settings.integrationMode = IntegrationMode::SEGMENT;
+			}
+			else {
+				printUsage();
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "--collision") == 0 && i + 1 < argc) {
+			std::string name = argv[++i];
+			if (name == "sampled") {
+				settings.collisionMode = CollisionMode::SAMPLED;
+			}
+			else if (name == "swept") {
+				settings.collisionMode = CollisionMode::SWEPT;
+			}
+			else {
+				printUsage();
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "--kinematics") == 0 && i + 1 < argc) {
+			std::string name = argv[++i];
+			if (name == "float") {
+				settings.kinematicsMode = KinematicsMode::FLOAT;
+			}
+			else if (name == "fixed") {
+				settings.kinematicsMode = KinematicsMode::FIXED;
+			}
+			else {
+				printUsage();
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "--bounce") == 0 && i + 1 < argc) {
+			if (!Robot::parseBounceMode(argv[++i], settings.bounceMode)) {
+				printUsage();
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "--bounce-candidates") == 0 && i + 1 < argc) {
+			settings.bounceCandidates = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--tileset") == 0 && i + 1 < argc) {
+			tilesetFilename = argv[++i];
+		}
+		else if (strcmp(argv[i], "--planner") == 0 && i + 1 < argc) {
+			if (!PathFinder::parsePlanner(argv[++i], settings.pathPlanner)) {
+				printUsage();
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "--diagonal") == 0) {
+			settings.allowDiagonal = true;
+		}
+		else if (strcmp(argv[i], "--return") == 0 && i + 1 < argc) {
+			std::string name = argv[++i];
+			if (name == "perimeter") {
+				settings.chargerReturn = ChargerReturn::PERIMETER;
+			}
+			else if (name == "field") {
+				settings.chargerReturn = ChargerReturn::DISTANCE_FIELD;
+			}
+			else {
+				printUsage();
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "--resume") == 0 && i + 1 < argc) {
+			std::string name = argv[++i];
+			if (name == "column") {
+				settings.resumeMode = ResumeMode::GOING_BACK;
+			}
+			else if (name == "path") {
+				settings.resumeMode = ResumeMode::SHORTEST_PATH;
+			}
+			else {
+				printUsage();
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "--obstacles") == 0 && i + 1 < argc) {
+			obstaclesFilename = argv[++i];
+		}
+		else if (strcmp(argv[i], "--path-cache") == 0 && i + 1 < argc) {
+			pathCacheSize = (size_t)atoll(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--route-legs") == 0 && i + 1 < argc) {
+			settings.routeLegReserve = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--async-planning") == 0 && i + 1 < argc) {
+			planningThreads = (unsigned int)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--planning-delay") == 0 && i + 1 < argc) {
+			settings.planningDelay = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--charge-curve") == 0 && i + 1 < argc) {
+			chargeCurveFilename = argv[++i];
+		}
+		else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+			runs = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			threads = (unsigned int)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			seed = strtoull(argv[++i], NULL, 10);
+			settings.seeded = true;
+			settings.seed = seed;
+		}
+		else if (strcmp(argv[i], "--stream") == 0 && i + 1 < argc) {
+			settings.stream = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			recordFilename = argv[++i];
+		}
+		else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			return runReplay(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--verify") == 0) {
+			verify = true;
+		}
+		else if (strcmp(argv[i], "--stuck-ticks") == 0 && i + 1 < argc) {
+			settings.stuckTicks = atoll(argv[++i]);
+		}
+		else if (argv[i][0] == '-') {
+			printUsage();
+			return -1;
+		}
+		else {
+			mapFilename = argv[i];
+		}
+	}
+
+	if (!chargeCurveFilename.empty() && !Robot::LoadChargeCurve(chargeCurveFilename, settings.chargeCurve)) {
+		return -1;
+	}
+
+	if (!obstaclesFilename.empty() && !Simulation::LoadObstacleEvents(obstaclesFilename, settings.obstacleEvents)) {
+		return -1;
+	}
+
+	Tileset tileset;
+	if (!tilesetFilename.empty() && !tileset.LoadTileset(tilesetFilename)) {
+		return -1;
+	}
+
+	TileMap tileMap(mapFilename, tileset);
+	if (pathCacheSize > 0) {
+		settings.pathCache = std::make_shared<PathCache>(pathCacheSize);
+	}
+	if (planningThreads > 0) {
+		settings.plannerPool = std::make_shared<PlannerPool>(planningThreads);
+	}
+	if (runs <= 1 && strategies.size() == 1) {
+		settings.strategy = strategies[0];
+		// recorded and verified runs need a known seed
+		if ((!recordFilename.empty() || verify) && !settings.seeded) {
+			std::random_device rd;
+			settings.seeded = true;
+			settings.seed = ((unsigned long long)rd() << 32) | rd();
+		}
+		SimulationResult result = runSingle(mapFilename, tileMap, settings, maxTicks);
+		if (!recordFilename.empty()) {
+			ReplayRecord record;
+			record.mapFilename = mapFilename;
+			record.tilesetFilename = tilesetFilename;
+			record.settings = settings;
+			record.maxTicks = maxTicks;
+			record.ticks = result.ticks;
+			record.trajectoryHash = result.trajectoryHash;
+			if (!SaveReplay(recordFilename, record))
+				return -1;
+		}
+		if (verify) {
+			// run it again on another thread, it must not share any state with the first run
+			SimulationResult secondResult;
+			std::thread verifyThread([&]() {
+				Simulation simulation(tileMap, settings);
+				secondResult = simulation.run(maxTicks);
+			});
+			verifyThread.join();
+			bool identical = secondResult.ticks == result.ticks && secondResult.trajectoryHash == result.trajectoryHash;
+			std::cout << "verify:         " << (identical ? "identical trajectories" : "MISMATCH") << std::endl;
+			if (!identical)
+				return 1;
+		}
+		return result.finished ? 0 : 1;
+	}
+
+	std::cout << "map: " << mapFilename << " (" << tileMap.getWidth() << "x" << tileMap.getHeight() << ")" << std::endl << std::endl;
+	for (unsigned int i = 0; i < strategies.size(); i++) {
+		settings.strategy = strategies[i];
+		runBatch(tileMap, settings, maxTicks, runs > 0 ? runs : 1, threads, seed);
+	}
+	return 0;
+}
@@ -0,0 +1,472 @@
+#include "HierarchicalMap.h"
+#include <algorithm>
+#include <cstdlib>
+#include "TileMap.h"
+
+/*
+	Constructor, the clusters are built on the first query
+	parameters:
+		tileMap		- the map, not owned
+		clusterSize	- width and height of a cluster in tiles
+*/
+HierarchicalMap::HierarchicalMap(const TileMap* tileMap, int clusterSize)
+	: tileMap(tileMap), clusterSize(clusterSize)
+{
+}
+
+/*
+	orders the open lists, the heap's top is the node with the lowest f
+*/
+bool HierarchicalMap::worseNode(const OpenNode& a, const OpenNode& b)
+{
+	return a.f > b.f;
+}
+
+/*
+	returns true if the robot can be on the tile
+*/
+bool HierarchicalMap::walkable(int col, int row) const
+{
+	return tileMap->validMapPosition(col, row) && !tileMap->isSolid(row, col);
+}
+
+/*
+	returns the cluster a tile is in
+*/
+int HierarchicalMap::clusterOf(int index) const
+{
+	return (index / width / clusterSize) * clustersWide + (index % width) / clusterSize;
+}
+
+/*
+	gets the tiles of a cluster, clusters on the right and bottom edges of the map can be smaller
+*/
+void HierarchicalMap::clusterBounds(int cluster, int& colMin, int& rowMin, int& colMax, int& rowMax) const
+{
+	colMin = (cluster % clustersWide) * clusterSize;
+	rowMin = (cluster / clustersWide) * clusterSize;
+	colMax = std::min(colMin + clusterSize, width) - 1;
+	rowMax = std::min(rowMin + clusterSize, height) - 1;
+}
+
+/*
+	finds the entrances on a border of a cluster (dx, dy is the step across it) and adds the tiles
+	on the cluster's side to nodes. An entrance is a run of open tiles facing open tiles across
+	the border, narrow ones get a transition in the middle and wide ones one at each end.
+	Both clusters find the same entrances, so the border needs no storage of its own.
+*/
+void HierarchicalMap::addBorderNodes(int cluster, int dx, int dy, std::vector<int>& nodes) const
+{
+	int colMin, rowMin, colMax, rowMax;
+	clusterBounds(cluster, colMin, rowMin, colMax, rowMax);
+	// the first border tile of the cluster and the step along the border
+	int length, firstCol, firstRow, alongX, alongY;
+	if (dx != 0) {																// left or right border
+		firstCol = dx > 0 ? colMax : colMin;
+		firstRow = rowMin;
+		alongX = 0;
+		alongY = 1;
+		length = rowMax - rowMin + 1;
+	}
+	else {																		// top or bottom border
+		firstCol = colMin;
+		firstRow = dy > 0 ? rowMax : rowMin;
+		alongX = 1;
+		alongY = 0;
+		length = colMax - colMin + 1;
+	}
+	int runStart = -1;
+	for (int i = 0; i <= length; i++) {
+		int col = firstCol + i * alongX, row = firstRow + i * alongY;
+		bool open = i < length && walkable(col, row) && walkable(col + dx, row + dy);
+		if (open && runStart == -1) {
+			runStart = i;
+		}
+		else if (!open && runStart != -1) {
+			int runEnd = i - 1;
+			if (runEnd - runStart + 1 < MIN_WIDE_ENTRANCE) {
+				int middle = (runStart + runEnd) / 2;
+				nodes.push_back(tileMap->tileIndex(firstRow + middle * alongY, firstCol + middle * alongX));
+			}
+			else {
+				nodes.push_back(tileMap->tileIndex(firstRow + runStart * alongY, firstCol + runStart * alongX));
+				nodes.push_back(tileMap->tileIndex(firstRow + runEnd * alongY, firstCol + runEnd * alongX));
+			}
+			runStart = -1;
+		}
+	}
+}
+
+/*
+	finds the entrances of a cluster and caches the distances between them
+*/
+void HierarchicalMap::buildCluster(int cluster)
+{
+	Cluster& c = clusters[cluster];
+	for (unsigned int i = 0; i < c.nodes.size(); i++)
+		nodeSlot[c.nodes[i]] = -1;
+	c.nodes.clear();
+	int clusterX = cluster % clustersWide, clusterY = cluster / clustersWide;
+	if (clusterX > 0)
+		addBorderNodes(cluster, -1, 0, c.nodes);
+	if (clusterX < clustersWide - 1)
+		addBorderNodes(cluster, 1, 0, c.nodes);
+	if (clusterY > 0)
+		addBorderNodes(cluster, 0, -1, c.nodes);
+	if (clusterY < clustersHigh - 1)
+		addBorderNodes(cluster, 0, 1, c.nodes);
+	// corner tiles can be an entrance of two borders
+	std::sort(c.nodes.begin(), c.nodes.end());
+	c.nodes.erase(std::unique(c.nodes.begin(), c.nodes.end()), c.nodes.end());
+
+	int nodeCount = (int)c.nodes.size();
+	c.distances.assign(nodeCount * nodeCount, -1);
+	for (int i = 0; i < nodeCount; i++) {
+		nodeSlot[c.nodes[i]] = i;
+		searchCluster(c.nodes[i], segmentSearch);
+		for (int j = 0; j < nodeCount; j++)
+			c.distances[i * nodeCount + j] = searchCost(segmentSearch, c.nodes[j]);
+	}
+}
+
+/*
+	Dijkstra from a tile to every tile of its cluster, without leaving the cluster
+	parameters:
+		sourceIndex	- the tile to start from
+		search		- set to the costs and parents of the tiles of the cluster
+*/
+void HierarchicalMap::searchCluster(int sourceIndex, ClusterSearch& search)
+{
+	static const Direction directions[8] = { UP, DOWN, LEFT, RIGHT, UP_LEFT, UP_RIGHT, DOWN_LEFT, DOWN_RIGHT };
+	int colMin, rowMin, colMax, rowMax;
+	search.cluster = clusterOf(sourceIndex);
+	clusterBounds(search.cluster, colMin, rowMin, colMax, rowMax);
+	search.cost.assign(clusterSize * clusterSize, -1);
+	search.parent.resize(clusterSize * clusterSize);
+
+	int directionCount = allowDiagonal ? 8 : 4;
+	int sourceCol = sourceIndex % width, sourceRow = sourceIndex / width;
+	search.cost[(sourceRow - rowMin) * clusterSize + sourceCol - colMin] = 0;
+	clusterOpen.clear();
+	clusterOpen.push_back({ 0, sourceIndex });
+	while (!clusterOpen.empty()) {
+		std::pop_heap(clusterOpen.begin(), clusterOpen.end(), worseNode);
+		OpenNode node = clusterOpen.back();
+		clusterOpen.pop_back();
+		int col = node.index % width, row = node.index / width;
+		if (node.f != search.cost[(row - rowMin) * clusterSize + col - colMin])
+			continue;												// stale entry
+		expandedNodes++;
+		for (int i = 0; i < directionCount; i++) {
+			int dx = (int)Robot::directionTable[directions[i]][0];
+			int dy = (int)Robot::directionTable[directions[i]][1];
+			int nextCol = col + dx, nextRow = row + dy;
+			if (nextCol < colMin || nextCol > colMax || nextRow < rowMin || nextRow > rowMax
+				|| tileMap->isSolid(nextRow, nextCol))
+				continue;
+			if (dx != 0 && dy != 0 && (tileMap->isSolid(row, nextCol) || tileMap->isSolid(nextRow, col)))
+				continue;											// never cut the corner of a solid tile
+			int next = (nextRow - rowMin) * clusterSize + nextCol - colMin;
+			int nextCost = node.f + (dx != 0 && dy != 0 ? DIAGONAL_COST : STRAIGHT_COST);
+			if (search.cost[next] == -1 || nextCost < search.cost[next]) {
+				search.cost[next] = nextCost;
+				search.parent[next] = node.index;
+				clusterOpen.push_back({ nextCost, tileMap->tileIndex(nextRow, nextCol) });
+				std::push_heap(clusterOpen.begin(), clusterOpen.end(), worseNode);
+			}
+		}
+	}
+}
+
+/*
+	returns the cost of a tile in a cluster search, -1 if it wasn't reached
+*/
+int HierarchicalMap::searchCost(const ClusterSearch& search, int index) const
+{
+	int colMin, rowMin, colMax, rowMax;
+	clusterBounds(search.cluster, colMin, rowMin, colMax, rowMax);
+	return search.cost[(index / width - rowMin) * clusterSize + index % width - colMin];
+}
+
+/*
+	appends the tiles of a cluster search's path after from, up to and including to
+	parameters:
+		search	- a cluster search that started at from
+		from	- the start of the search
+		to		- a tile the search reached
+*/
+void HierarchicalMap::appendSegment(const ClusterSearch& search, int from, int to, std::vector<glm::vec2>& path) const
+{
+	int colMin, rowMin, colMax, rowMax;
+	clusterBounds(search.cluster, colMin, rowMin, colMax, rowMax);
+	size_t begin = path.size();
+	for (int index = to; index != from; index = search.parent[(index / width - rowMin) * clusterSize + index % width - colMin])
+		path.push_back(glm::vec2(index % width, index / width));
+	std::reverse(path.begin() + begin, path.end());
+}
+
+/*
+	estimated cost from a tile to the goal, Manhattan or octile distance
+*/
+int HierarchicalMap::heuristic(int index, int goalIndex) const
+{
+	int dx = abs(index % width - goalIndex % width);
+	int dy = abs(index / width - goalIndex / width);
+	if (!allowDiagonal)
+		return STRAIGHT_COST * (dx + dy);
+	return STRAIGHT_COST * (dx + dy) + (DIAGONAL_COST - 2 * STRAIGHT_COST) * std::min(dx, dy);
+}
+
+/*
+	updates a node of the abstract search if it's cheaper to reach through another node
+	parameters:
+		from		- the node being expanded
+		next		- its neighbour, width * height for the goal
+		stepCost	- cost from from to next
+		goalIndex	- the goal tile, for the heuristic
+*/
+void HierarchicalMap::relax(int from, int next, int stepCost, int goalIndex)
+{
+	int nextCost = cost[from] + stepCost;
+	if (closed[next] == searchNumber || (visited[next] == searchNumber && nextCost >= cost[next]))
+		return;
+	visited[next] = searchNumber;
+	cost[next] = nextCost;
+	parent[next] = from;
+	open.push_back({ nextCost + (next == width * height ? 0 : heuristic(next, goalIndex)), next });
+	std::push_heap(open.begin(), open.end(), worseNode);
+}
+
+/*
+	splits the map into clusters and builds all of them
+*/
+void HierarchicalMap::build()
+{
+	width = tileMap->getWidth();
+	height = tileMap->getHeight();
+	clustersWide = (width + clusterSize - 1) / clusterSize;
+	clustersHigh = (height + clusterSize - 1) / clusterSize;
+	clusters.assign(clustersWide * clustersHigh, Cluster());
+	nodeSlot.assign(width * height, -1);
+	pathSlot.assign(width * height, -1);
+	// the abstract search has one more node, the goal
+	visited.assign(width * height + 1, 0);
+	closed.assign(width * height + 1, 0);
+	cost.resize(width * height + 1);
+	parent.resize(width * height + 1);
+	searchNumber = 0;
+	for (unsigned int i = 0; i < clusters.size(); i++)
+		buildCluster(i);
+	syncedEdits = (unsigned int)tileMap->getSolidEdits().size();
+	built = true;
+}
+
+/*
+	rebuilds the clusters around the tiles that turned solid or open since the last update,
+	a tile on a cluster border changes the entrances of the cluster across the border too
+*/
+void HierarchicalMap::update()
+{
+	const std::vector<int>& edits = tileMap->getSolidEdits();
+	if (!built || tileMap->getWidth() != width || tileMap->getHeight() != height || edits.size() < syncedEdits) {
+		build();
+		return;
+	}
+	std::vector<int> dirtyClusters;
+	for (unsigned int i = syncedEdits; i < edits.size(); i++) {
+		int col = edits[i] % width, row = edits[i] / width;
+		int cluster = clusterOf(edits[i]);
+		int clusterX = cluster % clustersWide, clusterY = cluster / clustersWide;
+		dirtyClusters.push_back(cluster);
+		if (col % clusterSize == 0 && clusterX > 0)
+			dirtyClusters.push_back(cluster - 1);
+		if ((col % clusterSize == clusterSize - 1 || col == width - 1) && clusterX < clustersWide - 1)
+			dirtyClusters.push_back(cluster + 1);
+		if (row % clusterSize == 0 && clusterY > 0)
+			dirtyClusters.push_back(cluster - clustersWide);
+		if ((row % clusterSize == clusterSize - 1 || row == height - 1) && clusterY < clustersHigh - 1)
+			dirtyClusters.push_back(cluster + clustersWide);
+	}
+	std::sort(dirtyClusters.begin(), dirtyClusters.end());
+	dirtyClusters.erase(std::unique(dirtyClusters.begin(), dirtyClusters.end()), dirtyClusters.end());
+	for (unsigned int i = 0; i < dirtyClusters.size(); i++)
+		buildCluster(dirtyClusters[i]);
+	syncedEdits = (unsigned int)edits.size();
+}
+
+/*
+	Finds a path from start to goal: first inside the start cluster, then on the graph of entrances
+	from the entrances the start reaches to the ones that reach the goal, and finally refines
+	each step between two entrances of the same cluster with a search of that cluster.
+	parameters:
+		startIndex, goalIndex	- tile indices, both open tiles
+		path					- set to the tiles from start to goal, both included
+	returns false if the goal is unreachable, path is then left empty
+*/
+bool HierarchicalMap::findPath(int startIndex, int goalIndex, std::vector<glm::vec2>& path)
+{
+	update();
+	expandedNodes = 0;
+	path.clear();
+
+	// a detour inside the start cluster doesn't need the abstract graph
+	int startCluster = clusterOf(startIndex), goalCluster = clusterOf(goalIndex);
+	searchCluster(startIndex, startSearch);
+	if (startCluster == goalCluster && searchCost(startSearch, goalIndex) != -1) {
+		path.push_back(glm::vec2(startIndex % width, startIndex / width));
+		appendSegment(startSearch, startIndex, goalIndex, path);
+		smoothPath(path);
+		return true;
+	}
+	searchCluster(goalIndex, goalSearch);
+
+	// A* on the entrances, the start is connected to the entrances of its cluster it reaches,
+	// the goal (at index width * height) to the entrances of its cluster that reach it
+	int goalNode = width * height;
+	searchNumber++;
+	if (searchNumber == 0) {
+		visited.assign(visited.size(), 0);
+		closed.assign(closed.size(), 0);
+		searchNumber = 1;
+	}
+	open.clear();
+	const Cluster& first = clusters[startCluster];
+	for (unsigned int i = 0; i < first.nodes.size(); i++) {
+		int startCost = searchCost(startSearch, first.nodes[i]);
+		if (startCost == -1)
+			continue;
+		visited[first.nodes[i]] = searchNumber;
+		cost[first.nodes[i]] = startCost;
+		parent[first.nodes[i]] = -1;
+		open.push_back({ startCost + heuristic(first.nodes[i], goalIndex), first.nodes[i] });
+		std::push_heap(open.begin(), open.end(), worseNode);
+	}
+	bool found = false;
+	while (!open.empty()) {
+		std::pop_heap(open.begin(), open.end(), worseNode);
+		OpenNode node = open.back();
+		open.pop_back();
+		if (closed[node.index] == searchNumber)
+			continue;													// stale entry, expanded already
+		closed[node.index] = searchNumber;
+		expandedNodes++;
+		if (node.index == goalNode) {
+			found = true;
+			break;
+		}
+		int cluster = clusterOf(node.index);
+		const Cluster& c = clusters[cluster];
+		int slot = nodeSlot[node.index], nodeCount = (int)c.nodes.size();
+		int col = node.index % width, row = node.index / width;
+		// to the other entrances of the cluster, with the cached distances
+		for (int j = 0; j < nodeCount; j++) {
+			int distance = c.distances[slot * nodeCount + j];
+			if (j != slot && distance != -1)
+				relax(node.index, c.nodes[j], distance, goalIndex);
+		}
+		// across the border, to entrances of the neighbouring clusters
+		int across[4][2] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } };
+		for (unsigned int i = 0; i < 4; i++) {
+			int nextCol = col + across[i][0], nextRow = row + across[i][1];
+			if (!tileMap->validMapPosition(nextCol, nextRow))
+				continue;
+			int next = tileMap->tileIndex(nextRow, nextCol);
+			if (nodeSlot[next] != -1 && clusterOf(next) != cluster)
+				relax(node.index, next, STRAIGHT_COST, goalIndex);
+		}
+		// to the goal
+		if (cluster == goalCluster) {
+			int goalCost = searchCost(goalSearch, node.index);
+			if (goalCost != -1)
+				relax(node.index, goalNode, goalCost, goalIndex);
+		}
+	}
+	if (!found)
+		return false;
+
+	// the entrances the path goes through, from the start side to the goal side
+	abstractPath.clear();
+	for (int index = parent[goalNode]; index != -1; index = parent[index])
+		abstractPath.push_back(index);
+	std::reverse(abstractPath.begin(), abstractPath.end());
+
+	// refine, start to the first entrance, entrance to entrance, last entrance to the goal
+	path.push_back(glm::vec2(startIndex % width, startIndex / width));
+	appendSegment(startSearch, startIndex, abstractPath[0], path);
+	for (unsigned int i = 0; i + 1 < abstractPath.size(); i++) {
+		int from = abstractPath[i], to = abstractPath[i + 1];
+		if (clusterOf(from) == clusterOf(to)) {
+			searchCluster(from, segmentSearch);
+			appendSegment(segmentSearch, from, to, path);
+		}
+		else {
+			path.push_back(glm::vec2(to % width, to / width));		// one step across the border
+		}
+	}
+	// the goal search started at the goal, its parents lead to the goal
+	for (int index = abstractPath.back(); index != goalIndex; ) {
+		int colMin, rowMin, colMax, rowMax;
+		clusterBounds(goalSearch.cluster, colMin, rowMin, colMax, rowMax);
+		index = goalSearch.parent[(index / width - rowMin) * clusterSize + index % width - colMin];
+		path.push_back(glm::vec2(index % width, index / width));
+	}
+	smoothPath(path);
+	return true;
+}
+
+/*
+	Shortens a refined path the way Botea et al. do: from every tile of the path, lines of open tiles
+	are walked straight (and diagonally with diagonal moves) up to two clusters far, and when a line
+	meets the path further on for less than the path costs in between, it replaces that stretch.
+	Starting from the tile the line ends on, the next shortcut is looked for, and so on to the goal.
+*/
+void HierarchicalMap::smoothPath(std::vector<glm::vec2>& path)
+{
+	static const int directions[8][2] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 }, { -1, -1 }, { 1, -1 }, { -1, 1 }, { 1, 1 } };
+	int directionCount = allowDiagonal ? 8 : 4;
+	int range = 2 * clusterSize;
+	int last = (int)path.size() - 1;
+	pathCost.resize(path.size());
+	for (int i = 0; i <= last; i++) {
+		bool diagonal = i > 0 && path[i].x != path[i - 1].x && path[i].y != path[i - 1].y;
+		pathCost[i] = i == 0 ? 0 : pathCost[i - 1] + (diagonal ? DIAGONAL_COST : STRAIGHT_COST);
+		pathSlot[(int)path[i].y * width + (int)path[i].x] = i;
+	}
+
+	smoothed.clear();
+	smoothed.push_back(path[0]);
+	int i = 0;
+	while (i < last) {
+		int col = (int)path[i].x, row = (int)path[i].y;
+		int bestSlot = i + 1, bestDirection = -1, bestSteps = 0;		// the farthest tile of the path a line cuts to
+		for (int d = 0; d < directionCount; d++) {
+			int dx = directions[d][0], dy = directions[d][1];
+			int stepCost = dx != 0 && dy != 0 ? DIAGONAL_COST : STRAIGHT_COST;
+			int lineCol = col, lineRow = row;
+			for (int steps = 1; steps <= range; steps++) {
+				if (!walkable(lineCol + dx, lineRow + dy)
+					|| (dx != 0 && dy != 0 && (!walkable(lineCol + dx, lineRow) || !walkable(lineCol, lineRow + dy))))
+					break;													// no corner cutting, same as the searches
+				lineCol += dx;
+				lineRow += dy;
+				int slot = pathSlot[lineRow * width + lineCol];
+				if (slot > bestSlot && steps * stepCost < pathCost[slot] - pathCost[i]) {
+					bestSlot = slot;
+					bestDirection = d;
+					bestSteps = steps;
+				}
+			}
+		}
+		if (bestDirection == -1) {
+			smoothed.push_back(path[i + 1]);
+		}
+		else {
+			for (int steps = 1; steps <= bestSteps; steps++)
+				smoothed.push_back(glm::vec2(col + directions[bestDirection][0] * steps, row + directions[bestDirection][1] * steps));
+		}
+		i = bestSlot;
+	}
+	for (int j = 0; j <= last; j++)
+		pathSlot[(int)path[j].y * width + (int)path[j].x] = -1;
+	path.swap(smoothed);
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+class TileMap;
+
+/*
+	Hierarchical path finding (HPA*) for large maps.
+	The map is split into square clusters, the open tiles facing each other across a cluster border
+	are the entrances, and the distances between the entrances of a cluster are computed once and cached.
+	A path query searches the small graph of entrances and only then the tiles of the clusters
+	the path goes through, so long queries don't depend much on the size of the map.
+	When tiles turn solid or open (TileMap::setTile) only the clusters around them are rebuilt.
+	Paths are near optimal: a detour inside one cluster is taken as is if there is one, and the path
+	goes through entrances the shortest path may not, which the smoothing pass (see smoothPath) mostly
+	straightens out. They can still be a little longer than the shortest.
+	Reference used:
+		Botea, A., Muller, M., Schaeffer, J. (2004). Near Optimal Hierarchical Path-Finding.
+			Journal of Game Development, 1(1).
+*/
+class HierarchicalMap
+{
+private:
+	// entrances of a cluster and the cached distances between them
+	struct Cluster {
+		std::vector<int> nodes;					// tile indices of the entrance tiles of the cluster
+		std::vector<int> distances;				// nodes.size() squared costs, -1 if not connected inside the cluster
+	};
+	// costs and parents of a search inside one cluster, indexed by the tile's position in the cluster
+	struct ClusterSearch {
+		int cluster = -1;
+		std::vector<int> cost;					// -1 if not reached
+		std::vector<int> parent;				// tile index each tile was reached from
+	};
+	// an entry of an open list
+	struct OpenNode {
+		int f;
+		int index;
+	};
+	static const int STRAIGHT_COST = 10;		// same step costs as PathFinder
+	static const int DIAGONAL_COST = 14;
+	static const int MIN_WIDE_ENTRANCE = 6;		// entrances this wide get a transition at both ends instead of the middle
+	// =========== DATA MEMBERS ==============
+	const TileMap* tileMap;						// the map, not owned
+	int clusterSize;							// width and height of a cluster in tiles
+	bool allowDiagonal = false;					// move diagonally inside clusters
+	bool built = false;							// the clusters match the map up to syncedEdits
+	unsigned int syncedEdits = 0;				// edits of the map (TileMap::getSolidEdits) already applied
+	int width = 0, height = 0;					// map size in tiles
+	int clustersWide = 0, clustersHigh = 0;		// map size in clusters
+	std::vector<Cluster> clusters;
+	std::vector<int> nodeSlot;					// per tile, position of the tile in its cluster's nodes, -1 if not an entrance
+	// search buffers, reused between queries
+	ClusterSearch startSearch, goalSearch, segmentSearch;
+	std::vector<OpenNode> open;					// abstract search open list
+	std::vector<OpenNode> clusterOpen;			// cluster search open list
+	std::vector<unsigned int> visited, closed;	// stamped with searchNumber like PathFinder
+	std::vector<int> cost, parent;				// abstract search, per tile plus the goal at the end
+	std::vector<int> abstractPath;
+	std::vector<int> pathSlot;					// per tile, position of the tile in the path being smoothed, -1 if not on it
+	std::vector<int> pathCost;					// cost from the start to each tile of the path being smoothed
+	std::vector<glm::vec2> smoothed;
+	unsigned int searchNumber = 0;
+	int expandedNodes = 0;						// abstract nodes and tiles expanded by the last query
+	static bool worseNode(const OpenNode& a, const OpenNode& b);
+	bool walkable(int col, int row) const;
+	int clusterOf(int index) const;
+	void clusterBounds(int cluster, int& colMin, int& rowMin, int& colMax, int& rowMax) const;
+	void addBorderNodes(int cluster, int dx, int dy, std::vector<int>& nodes) const;
+	void buildCluster(int cluster);
+	void searchCluster(int sourceIndex, ClusterSearch& search);
+	int searchCost(const ClusterSearch& search, int index) const;
+	void appendSegment(const ClusterSearch& search, int from, int to, std::vector<glm::vec2>& path) const;
+	int heuristic(int index, int goalIndex) const;
+	void relax(int from, int next, int stepCost, int goalIndex);
+	void smoothPath(std::vector<glm::vec2>& path);
+	void build();
+	void update();
+public:
+	// =========== FUNCTIONS ====================
+	// refer to cpp files for more detailed explanation
+	HierarchicalMap(const TileMap* tileMap, int clusterSize = 16);
+	bool findPath(int startIndex, int goalIndex, std::vector<glm::vec2>& path);
+
+	// getters and setters
+	void setAllowDiagonal(bool allowDiagonal) {
+		if (this->allowDiagonal != allowDiagonal)
+			built = false;
+		this->allowDiagonal = allowDiagonal;
+	}
+
+	int getExpandedNodes() const {
+		return expandedNodes;
+	}
+
+	int getClusterSize() const {
+		return clusterSize;
+	}
+};
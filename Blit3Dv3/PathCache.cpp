@@ -0,0 +1,89 @@
+#include "PathCache.h"
+#include "PathFinder.h"
+
+/*
+	mixes the fields of a key into one value (splitmix64 finalizer after each field)
+*/
+size_t PathCache::KeyHash::operator()(const PathCacheKey& key) const
+{
+	unsigned long long fields[4] = {
+		key.mapVersion,
+		(unsigned long long)(unsigned int)key.startIndex,
+		(unsigned long long)(unsigned int)key.goalIndex,
+		((unsigned long long)key.planner << 16) | ((unsigned long long)key.allowDiagonal << 8)
+			| (unsigned long long)(unsigned char)key.preferredDirection
+	};
+	unsigned long long hash = 0;
+	for (int i = 0; i < 4; i++) {
+		hash ^= fields[i] + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+		hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+		hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+		hash ^= hash >> 31;
+	}
+	return (size_t)hash;
+}
+
+/*
+	Constructor, an empty cache that keeps at most capacity paths
+*/
+PathCache::PathCache(size_t capacity)
+	: capacity(capacity > 0 ? capacity : 1)
+{
+	index.reserve(this->capacity);
+}
+
+/*
+	looks a search up
+	parameters:
+		key		- the search
+		found	- set to whether the search found a path
+		path	- set to the path found, reuses its storage
+	returns false if the search isn't cached, found and path are left alone then
+*/
+bool PathCache::lookup(const PathCacheKey& key, bool& found, std::vector<glm::vec2>& path)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto entry = index.find(key);
+	if (entry == index.end()) {
+		misses++;
+		return false;
+	}
+	hits++;
+	entries.splice(entries.begin(), entries, entry->second);		// now the most recently used
+	found = entry->second->found;
+	path.assign(entry->second->path.begin(), entry->second->path.end());
+	return true;
+}
+
+/*
+	remembers the result of a search, dropping the least recently used one if the cache is full
+	parameters:
+		key		- the search
+		found	- whether the search found a path
+		path	- the path found, empty if none
+*/
+void PathCache::store(const PathCacheKey& key, bool found, const std::vector<glm::vec2>& path)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto entry = index.find(key);
+	if (entry != index.end()) {										// another robot got there first
+		entries.splice(entries.begin(), entries, entry->second);
+		return;
+	}
+	if (entries.size() >= capacity) {
+		index.erase(entries.back().key);
+		entries.pop_back();
+	}
+	entries.push_front(Entry{ key, found, path });
+	index[key] = entries.begin();
+}
+
+/*
+	drops every cached path, the counters are kept
+*/
+void PathCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+	index.clear();
+}
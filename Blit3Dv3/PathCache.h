@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Direction.h"
+
+enum class PathPlanner;
+
+// what a path search depends on, two searches with the same key find the same path
+struct PathCacheKey {
+	unsigned long long mapVersion;		// TileMap::getVersion of the map searched
+	int startIndex;						// tile indices of the start and goal
+	int goalIndex;
+	PathPlanner planner;
+	bool allowDiagonal;
+	Direction preferredDirection;		// NONE for the planners that don't break ties with it
+
+	bool operator==(const PathCacheKey& other) const {
+		return mapVersion == other.mapVersion && startIndex == other.startIndex && goalIndex == other.goalIndex
+			&& planner == other.planner && allowDiagonal == other.allowDiagonal
+			&& preferredDirection == other.preferredDirection;
+	}
+};
+
+/*
+	Remembers the paths found by PathFinders so a detour searched before costs a hash lookup.
+	The zigzag runs into the same obstacles at the same rows after every recharge, and every run
+	of a batch does it again, so one cache is shared by all the robots of a batch (see SimulationSettings),
+	lookups and stores are locked so the runs can share it from their threads.
+	Keys include the version of the map, an edit gives the map a new version so paths found before it
+	are never used again, they're dropped as the least recently used entries when the cache is full.
+	Searches that found no path are cached too.
+*/
+class PathCache
+{
+private:
+	struct KeyHash {
+		size_t operator()(const PathCacheKey& key) const;
+	};
+	struct Entry {
+		PathCacheKey key;
+		bool found;
+		std::vector<glm::vec2> path;
+	};
+	// =========== DATA MEMBERS ==============
+	std::mutex mutex;
+	size_t capacity;									// most entries kept
+	std::list<Entry> entries;							// most recently used first
+	std::unordered_map<PathCacheKey, std::list<Entry>::iterator, KeyHash> index;
+	long long hits = 0;
+	long long misses = 0;
+public:
+	// =========== FUNCTIONS ====================
+	// refer to cpp files for more detailed explanation
+	PathCache(size_t capacity = 4096);
+	PathCache(const PathCache&) = delete;
+	PathCache& operator=(const PathCache&) = delete;
+	bool lookup(const PathCacheKey& key, bool& found, std::vector<glm::vec2>& path);
+	void store(const PathCacheKey& key, bool found, const std::vector<glm::vec2>& path);
+	void clear();
+
+	// getters, locked like the rest
+	long long getHits() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return hits;
+	}
+
+	long long getMisses() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return misses;
+	}
+
+	size_t getSize() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return entries.size();
+	}
+
+	size_t getCapacity() const {
+		return capacity;
+	}
+};
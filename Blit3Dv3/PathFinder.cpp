@@ -0,0 +1,728 @@
+#include "PathFinder.h"
+#include <algorithm>
+#include <cstdlib>
+#include "TileMap.h"
+
+/*
+	Constructor, the buffers are sized on the first search
+*/
+PathFinder::PathFinder(const TileMap* tileMap)
+	: tileMap(tileMap), hierarchy(tileMap), incremental(tileMap)
+{
+}
+
+/*
+	returns the name of a planner, as used on the command line and in replay files
+*/
+const char* PathFinder::plannerName(PathPlanner planner)
+{
+	switch (planner) {
+	case PathPlanner::ASTAR:
+		return "astar";
+	case PathPlanner::JPS:
+		return "jps";
+	case PathPlanner::HPA:
+		return "hpa";
+	case PathPlanner::DSTAR:
+		return "dstar";
+	default:
+		return "bfs";
+	}
+}
+
+/*
+	reads a planner name written by plannerName
+	returns false if the name isn't a planner
+*/
+bool PathFinder::parsePlanner(std::string name, PathPlanner& planner)
+{
+	const PathPlanner planners[] = { PathPlanner::BFS, PathPlanner::ASTAR, PathPlanner::JPS, PathPlanner::HPA, PathPlanner::DSTAR };
+	for (unsigned int i = 0; i < 5; i++) {
+		if (name == plannerName(planners[i])) {
+			planner = planners[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+	sizes the buffers for the map and starts a new search number
+*/
+void PathFinder::prepare()
+{
+	unsigned int tileCount = (unsigned int)(tileMap->getWidth() * tileMap->getHeight());
+	if (visited.size() != tileCount) {
+		visited.assign(tileCount, 0);
+		closed.assign(tileCount, 0);
+		parent.resize(tileCount);
+		cost.resize(tileCount);
+		queue.resize(tileCount);
+		searchNumber = 0;
+	}
+	searchNumber++;
+	if (searchNumber == 0) {		// wrapped around, old stamps could match again
+		visited.assign(tileCount, 0);
+		closed.assign(tileCount, 0);
+		searchNumber = 1;
+	}
+}
+
+/*
+	labels the connected areas of open tiles, each tile gets the index of the first tile of its area,
+	flooded with the BFS queue moving up, down, left and right only: a diagonal move never cuts a corner,
+	so it doesn't connect anything the straight moves don't
+*/
+void PathFinder::labelComponents()
+{
+	int width = tileMap->getWidth();
+	int tileCount = width * tileMap->getHeight();
+	int neighbours[8], costs[8];
+	component.assign(tileCount, -1);
+	for (int first = 0; first < tileCount; first++) {
+		if (component[first] != -1 || tileMap->isSolid(first / width, first % width))
+			continue;
+		int head = 0, tail = 0;
+		component[first] = first;
+		queue[tail++] = first;
+		while (head < tail) {
+			int neighbourCount = getNeighbours(queue[head++], false, neighbours, costs);
+			for (int i = 0; i < neighbourCount; i++) {
+				if (component[neighbours[i]] == -1) {
+					component[neighbours[i]] = first;
+					queue[tail++] = neighbours[i];
+				}
+			}
+		}
+	}
+	componentVersion = tileMap->getVersion();
+}
+
+/*
+	returns false if the goal is in another area of the map than the start, so no search can reach it,
+	the areas are labelled again first if the map changed since
+	a start on a solid tile (an obstacle put on the robot) can't be told, it is searched from as usual
+*/
+bool PathFinder::reachable(int startIndex, int goalIndex)
+{
+	if (componentVersion != tileMap->getVersion() || component.size() != visited.size())
+		labelComponents();
+	return component[startIndex] == -1 || component[startIndex] == component[goalIndex];
+}
+
+/*
+	gets the tiles the robot can move to from a tile,
+	in the order UP, DOWN, LEFT, RIGHT then the diagonals
+	parameters:
+		index		- the tile
+		diagonal	- include the diagonal moves
+		neighbours	- set to the tile indices, room for 8
+		costs		- set to the cost of each step, room for 8
+	returns the number of neighbours
+*/
+int PathFinder::getNeighbours(int index, bool diagonal, int neighbours[], int costs[]) const
+{
+	static const Direction straightDirections[4] = { UP, DOWN, LEFT, RIGHT };
+	static const Direction diagonalDirections[4] = { UP_LEFT, UP_RIGHT, DOWN_LEFT, DOWN_RIGHT };
+	int width = tileMap->getWidth();
+	int col = index % width, row = index / width;
+	int count = 0;
+	for (unsigned int i = 0; i < 4; i++) {
+		int nextCol = col + (int)Robot::directionTable[straightDirections[i]][0];
+		int nextRow = row + (int)Robot::directionTable[straightDirections[i]][1];
+		if (tileMap->validMapPosition(nextCol, nextRow) && !tileMap->isSolid(nextRow, nextCol)) {
+			neighbours[count] = tileMap->tileIndex(nextRow, nextCol);
+			costs[count++] = STRAIGHT_COST;
+		}
+	}
+	if (!diagonal)
+		return count;
+	for (unsigned int i = 0; i < 4; i++) {
+		int nextCol = col + (int)Robot::directionTable[diagonalDirections[i]][0];
+		int nextRow = row + (int)Robot::directionTable[diagonalDirections[i]][1];
+		// both tiles beside the diagonal must be free too, the robot would clip their corner otherwise
+		if (tileMap->validMapPosition(nextCol, nextRow) && !tileMap->isSolid(nextRow, nextCol)
+			&& !tileMap->isSolid(row, nextCol) && !tileMap->isSolid(nextRow, col)) {
+			neighbours[count] = tileMap->tileIndex(nextRow, nextCol);
+			costs[count++] = DIAGONAL_COST;
+		}
+	}
+	return count;
+}
+
+/*
+	estimated cost from a tile to the goal, never more than the real cost:
+	Manhattan distance for straight moves only, octile distance with diagonal moves
+*/
+int PathFinder::heuristic(int index, int goalIndex, bool diagonal) const
+{
+	int width = tileMap->getWidth();
+	int dx = abs(index % width - goalIndex % width);
+	int dy = abs(index / width - goalIndex / width);
+	if (!diagonal)
+		return STRAIGHT_COST * (dx + dy);
+	return STRAIGHT_COST * (dx + dy) + (DIAGONAL_COST - 2 * STRAIGHT_COST) * std::min(dx, dy);
+}
+
+/*
+	Finds a path from start to goal with the planner of this path finder.
+	BFS, A*, JPS and D* Lite find a shortest path, HPA a near optimal one (see HierarchicalMap),
+	smoothed but sometimes a little longer than the shortest.
+	Every tile remembers the tile it was reached from, the path is read back from the goal.
+	parameters:
+		start, goal			- tile map positions, x is the column and y the row
+		path				- set to the tiles from start to goal, both included, reuses its storage
+		preferredDirection	- A* breaks ties between equally good tiles toward this direction
+							  (the zigzag direction), so detours keep going the way the robot mows
+	returns false if the goal is unreachable, path is then left empty
+	with a PathCache the search is only done the first time, later the cached path is copied
+*/
+bool PathFinder::findPath(glm::vec2 start, glm::vec2 goal, std::vector<glm::vec2>& path,
+	Direction preferredDirection)
+{
+	path.clear();
+	expandedTiles = 0;
+	searches++;
+	int startX = (int)start.x, startY = (int)start.y;
+	int goalX = (int)goal.x, goalY = (int)goal.y;
+	if (!tileMap->validMapPosition(startX, startY) || !tileMap->validMapPosition(goalX, goalY)
+		|| tileMap->isSolid(goalY, goalX)) {
+		return false;													// nothing to search for
+	}
+
+	int startIndex = tileMap->tileIndex(startY, startX);
+	int goalIndex = tileMap->tileIndex(goalY, goalX);
+	if (!cache)
+		return search(startIndex, goalIndex, path, preferredDirection);
+
+	// only A* and JPS break ties with the preferred direction, the other planners find the same path anyway
+	bool breaksTies = planner == PathPlanner::ASTAR || planner == PathPlanner::JPS;
+	PathCacheKey key = { tileMap->getVersion(), startIndex, goalIndex, planner, allowDiagonal,
+		breaksTies ? preferredDirection : NONE };
+	bool found;
+	if (cache->lookup(key, found, path)) {
+		cacheHits++;
+		return found;
+	}
+	found = search(startIndex, goalIndex, path, preferredDirection);
+	cache->store(key, found, path);
+	return found;
+}
+
+/*
+	searches a path between two tiles with the planner of this path finder, see findPath
+	parameters:
+		startIndex, goalIndex	- tile indices of the start and the goal, the goal isn't solid
+		path					- set to the tiles from start to goal, both included, left empty if there is no path
+		preferredDirection		- tie-breaking direction of A* and JPS
+	returns false if the goal is unreachable
+*/
+bool PathFinder::search(int startIndex, int goalIndex, std::vector<glm::vec2>& path, Direction preferredDirection)
+{
+	int width = tileMap->getWidth();
+	if (planner == PathPlanner::HPA) {
+		// the hierarchy refines its own path
+		bool found = hierarchy.findPath(startIndex, goalIndex, path);
+		expandedTiles = hierarchy.getExpandedNodes();
+		totalExpandedTiles += expandedTiles;
+		return found;
+	}
+	if (planner == PathPlanner::DSTAR) {
+		// repairs the costs of the previous search if the goal is the same
+		bool found = incremental.findPath(startIndex, goalIndex, path);
+		expandedTiles = incremental.getExpandedTiles();
+		totalExpandedTiles += expandedTiles;
+		return found;
+	}
+	prepare();
+	if (!reachable(startIndex, goalIndex))
+		return false;													// don't flood the start's area looking for it
+	bool found;
+	if (planner == PathPlanner::ASTAR)
+		found = aStar(startIndex, goalIndex, preferredDirection);
+	else if (planner == PathPlanner::JPS)
+		found = jumpPointSearch(startIndex, goalIndex, preferredDirection);
+	else
+		found = breadthFirst(startIndex, goalIndex);
+	totalExpandedTiles += expandedTiles;
+	if (!found)
+		return false;													// goal is unreachable, no path
+
+	// walk the parents back to the start to get the length, then fill the path from its end,
+	// consecutive parents can be several tiles apart (JPS), the tiles in between are filled in
+	int length = 1;
+	for (int index = goalIndex; index != startIndex; index = parent[index])
+		length += segmentSteps(index, parent[index]);
+	path.resize(length);
+	int i = length - 1;
+	int col = goalIndex % width, row = goalIndex / width;
+	path[i] = glm::vec2(col, row);
+	for (int index = goalIndex; index != startIndex; index = parent[index]) {
+		int parentCol = parent[index] % width, parentRow = parent[index] / width;
+		while (col != parentCol || row != parentRow) {
+			col += (parentCol > col) - (parentCol < col);
+			row += (parentRow > row) - (parentRow < row);
+			path[--i] = glm::vec2(col, row);
+		}
+	}
+	return true;
+}
+
+/*
+	returns the number of moves on the straight or diagonal line between two tiles
+*/
+int PathFinder::segmentSteps(int from, int to) const
+{
+	int width = tileMap->getWidth();
+	int dx = abs(from % width - to % width);
+	int dy = abs(from / width - to / width);
+	return std::max(dx, dy);
+}
+
+/*
+	Breadth-First search, finds the path with the fewest steps
+	Reference used:
+		Breadth-First Search. (n.d.). In Wikipedia.
+			Retrieved November 20, 2023, from https://en.wikipedia.org/wiki/Breadth-first_search
+	returns true if the goal was reached, the path is in parent
+*/
+bool PathFinder::breadthFirst(int startIndex, int goalIndex)
+{
+	int neighbours[8], costs[8];
+	int head = 0, tail = 0;
+	visited[startIndex] = searchNumber;
+	queue[tail++] = startIndex;
+	while (head < tail) {												// while the queue is not empty
+		int index = queue[head++];										// dequeue a tile
+		expandedTiles++;
+		if (index == goalIndex)
+			return true;
+		// neighbours in the same order as the old search, UP, DOWN, LEFT, RIGHT, so it finds the same paths
+		int neighbourCount = getNeighbours(index, allowDiagonal, neighbours, costs);
+		for (int i = 0; i < neighbourCount; i++) {
+			int next = neighbours[i];
+			if (visited[next] != searchNumber) {						// if not yet visited
+				visited[next] = searchNumber;							// mark it as visited
+				parent[next] = index;									// remember where it was reached from
+				queue[tail++] = next;									// enqueue the tile
+			}
+		}
+	}
+	return false;
+}
+
+/*
+	orders the A* open list, the heap's top is the node with the lowest f,
+	ties go to the node closest to the goal and then to the one furthest along the preferred direction
+*/
+bool PathFinder::worseNode(const OpenNode& a, const OpenNode& b)
+{
+	if (a.f != b.f)
+		return a.f > b.f;
+	if (a.h != b.h)
+		return a.h > b.h;
+	return a.progress < b.progress;
+}
+
+/*
+	A* search, a tile already expanded with a cheaper cost is skipped when it comes off the heap again
+	Reference used:
+		A* search algorithm. (n.d.). In Wikipedia.
+			Retrieved from https://en.wikipedia.org/wiki/A*_search_algorithm
+	returns true if the goal was reached, the path is in parent
+*/
+bool PathFinder::aStar(int startIndex, int goalIndex, Direction preferredDirection)
+{
+	int width = tileMap->getWidth();
+	int preferredX = 0, preferredY = 0;
+	if (preferredDirection < DIRECTION_COUNT) {
+		preferredX = (int)Robot::directionTable[preferredDirection][0];
+		preferredY = (int)Robot::directionTable[preferredDirection][1];
+	}
+	int startCol = startIndex % width, startRow = startIndex / width;
+	int neighbours[8], costs[8];
+
+	open.clear();
+	visited[startIndex] = searchNumber;
+	cost[startIndex] = 0;
+	int h = heuristic(startIndex, goalIndex, allowDiagonal);
+	open.push_back({ h, h, 0, startIndex });
+	while (!open.empty()) {
+		std::pop_heap(open.begin(), open.end(), worseNode);
+		OpenNode node = open.back();
+		open.pop_back();
+		if (closed[node.index] == searchNumber)
+			continue;													// stale entry, expanded already
+		closed[node.index] = searchNumber;
+		expandedTiles++;
+		if (node.index == goalIndex)
+			return true;
+		int neighbourCount = getNeighbours(node.index, allowDiagonal, neighbours, costs);
+		for (int i = 0; i < neighbourCount; i++) {
+			int next = neighbours[i];
+			if (closed[next] == searchNumber)
+				continue;
+			int nextCost = cost[node.index] + costs[i];
+			if (visited[next] != searchNumber || nextCost < cost[next]) {
+				visited[next] = searchNumber;
+				cost[next] = nextCost;
+				parent[next] = node.index;
+				h = heuristic(next, goalIndex, allowDiagonal);
+				int progress = (next % width - startCol) * preferredX + (next / width - startRow) * preferredY;
+				open.push_back({ nextCost + h, h, progress, next });
+				std::push_heap(open.begin(), open.end(), worseNode);
+			}
+		}
+	}
+	return false;
+}
+
+/*
+	returns true if the robot can be on the tile
+*/
+bool PathFinder::walkable(int col, int row) const
+{
+	return tileMap->validMapPosition(col, row) && !tileMap->isSolid(row, col);
+}
+
+/*
+	returns the entry of jumpDistances for a walk starting on a tile
+	parameters:
+		col, row	- the tile, from -1 to the width or height of the map (the border is 0, like a solid tile)
+		slot		- 0 to 3 straight up, down, left, right, 4 to 7 the diagonals up left, up right,
+					  down left, down right or, without diagonal moves, 4 and 5 the vertical walks up and down
+*/
+int PathFinder::jumpDistance(int col, int row, int slot) const
+{
+	int paddedWidth = tileMap->getWidth() + 2;
+	return jumpDistances[slot * paddedWidth * (tileMap->getHeight() + 2) + (row + 1) * paddedWidth + col + 1];
+}
+
+/*
+	Precomputes for every tile where a JPS walk starting on it stops, so a jump is a look up
+	instead of a walk (JPS+): n > 0 if it stops on a jump point n - 1 tiles on, -n if it runs into
+	a solid tile, the edge of the map or a corner after n open tiles, 0 for a solid tile.
+	Straight walks stop on a tile with a forced neighbour: a tile beside it is open but the one beside
+	the tile behind it is solid, so without corner cutting the only shortest way there goes through
+	this tile (see getJumpDirections). The walks that look sideways at every
+	tile, the diagonals or without diagonal moves the vertical ones, stop where a straight walk to
+	the side stops on one. Only the goal isn't in there, the jumps check it when they look a walk up.
+	The map gets a border of solid tiles so nothing needs a bounds check.
+	Done again whenever the map changed, a pass over the map per direction.
+	Reference used:
+		Harabor, D., Grastien, A. (2014). Improving Jump Point Search. ICAPS.
+*/
+void PathFinder::buildJumpDistances()
+{
+	static const int walks[8][2] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 }, { -1, -1 }, { 1, -1 }, { -1, 1 }, { 1, 1 } };
+	int width = tileMap->getWidth(), height = tileMap->getHeight();
+	int paddedWidth = width + 2, paddedCount = paddedWidth * (height + 2);
+	openTiles.assign(paddedCount, 0);
+	for (int row = 0; row < height; row++) {
+		for (int col = 0; col < width; col++)
+			openTiles[(row + 1) * paddedWidth + col + 1] = !tileMap->isSolid(row, col);
+	}
+	jumpDistances.assign(8 * paddedCount, 0);
+	const int* up = &jumpDistances[0];
+	const int* down = &jumpDistances[paddedCount];
+	const int* left = &jumpDistances[2 * paddedCount];
+	const int* right = &jumpDistances[3 * paddedCount];
+	for (int slot = 0; slot < (allowDiagonal ? 8 : 6); slot++) {
+		int dx = walks[slot][0], dy = walks[slot][1];
+		if (!allowDiagonal && slot >= 4) {								// vertical walks of the 4 connected search
+			dx = 0;
+			dy = slot == 4 ? -1 : 1;
+		}
+		int* distances = &jumpDistances[slot * paddedCount];
+		int ahead = dx + dy * paddedWidth;								// the next tile of the walk
+		int side = dx != 0 && dy != 0 ? 0 : (dx != 0 ? paddedWidth : 1);	// beside a straight walk
+		const int* sideways = dy < 0 ? up : down;						// the straight walks a diagonal looks along
+		const int* sideways2 = dx < 0 ? left : right;
+		// from the far end of the map, so the tile ahead is always done first
+		for (int rowStep = 0; rowStep < height; rowStep++) {
+			int row = dy > 0 ? height - 1 - rowStep : rowStep;
+			for (int colStep = 0; colStep < width; colStep++) {
+				int col = dx > 0 ? width - 1 - colStep : colStep;
+				int tile = (row + 1) * paddedWidth + col + 1;
+				if (!openTiles[tile])
+					continue;													// 0, solid
+				bool stop;
+				if (slot < 4)
+					stop = (openTiles[tile + side] && !openTiles[tile + side - ahead])
+						|| (openTiles[tile - side] && !openTiles[tile - side - ahead]);
+				else if (dx != 0)
+					stop = sideways2[tile + dx] > 0 || sideways[tile + dy * paddedWidth] > 0;
+				else
+					stop = left[tile - 1] > 0 || right[tile + 1] > 0;
+				if (stop)
+					distances[tile] = 1;
+				else if (dx != 0 && dy != 0 && (!openTiles[tile + dx] || !openTiles[tile + dy * paddedWidth]))
+					distances[tile] = -1;										// the next diagonal step would cut a corner
+				else
+					distances[tile] = distances[tile + ahead] > 0 ? distances[tile + ahead] + 1 : distances[tile + ahead] - 1;
+			}
+		}
+	}
+	jumpVersion = tileMap->getVersion();
+	jumpDiagonal = allowDiagonal;
+}
+
+/*
+	looks up where a walk from a tile stops in jumpDistances and checks the goal on the way: on the line
+	of a straight walk, or for the walks that look sideways, where they cross the goal's row or column
+	and a straight walk from there gets to it
+	parameters:
+		col, row	- the first tile of the walk
+		dx, dy		- the direction of the walk
+		slot		- the walk's slot in jumpDistances, see jumpDistance
+		goalIndex	- the goal of the search
+	returns the tile index of the jump point, -1 if the walk hits a solid tile or the edge of the map
+*/
+int PathFinder::lookUpJump(int col, int row, int dx, int dy, int slot, int goalIndex)
+{
+	int distance = jumpDistance(col, row, slot);
+	if (distance == 0)
+		return -1;
+	expandedTiles++;													// one look up for the whole walk
+	int lastStep = distance > 0 ? distance - 1 : -distance - 1;		// steps to the jump point or the last open tile
+	int stopStep = distance > 0 ? lastStep : -1;
+	int width = tileMap->getWidth();
+	int goalCol = goalIndex % width, goalRow = goalIndex / width;
+	int rowStep = dy != 0 ? (goalRow - row) * dy : (goalRow == row ? (goalCol - col) * dx : -1);
+	int colStep = dx != 0 ? (goalCol - col) * dx : (goalCol == col ? (goalRow - row) * dy : -1);
+	if (slot < 4) {														// straight, the goal has to be on the line
+		int goalStep = dx != 0 ? rowStep : colStep;
+		if (goalStep >= 0 && goalStep <= lastStep && (stopStep == -1 || goalStep < stopStep))
+			stopStep = goalStep;
+	}
+	else {
+		if (rowStep >= 0 && rowStep <= lastStep && (stopStep == -1 || rowStep < stopStep)) {
+			int stepCol = col + rowStep * dx;
+			if (stepCol == goalCol
+				|| (dx != 0 && lookUpJump(stepCol + dx, goalRow, dx, 0, dx < 0 ? 2 : 3, goalIndex) == goalIndex)
+				|| (dx == 0 && (lookUpJump(stepCol - 1, goalRow, -1, 0, 2, goalIndex) == goalIndex
+					|| lookUpJump(stepCol + 1, goalRow, 1, 0, 3, goalIndex) == goalIndex)))
+				stopStep = rowStep;
+		}
+		if (dx != 0 && colStep >= 0 && colStep <= lastStep && (stopStep == -1 || colStep < stopStep)) {
+			int stepRow = row + colStep * dy;
+			if (lookUpJump(goalCol, stepRow + dy, 0, dy, dy < 0 ? 0 : 1, goalIndex) == goalIndex)
+				stopStep = colStep;
+		}
+	}
+	if (stopStep == -1)
+		return -1;
+	return tileMap->tileIndex(row + stopStep * dy, col + stopStep * dx);
+}
+
+/*
+	gets the directions JPS has to look in from a jump point, pruning the ones
+	a path through the parent covers already: on a diagonal the two straight directions and the diagonal,
+	on a straight line the direction itself plus, where a forced neighbour made the jump stop here,
+	the side it is on and the diagonal ahead toward it
+	parameters:
+		index		- the jump point
+		parentIndex	- the jump point it was reached from, itself for the start
+		directions	- set to the x and y of each direction, room for 8
+	returns the number of directions
+*/
+int PathFinder::getJumpDirections(int index, int parentIndex, int directions[][2]) const
+{
+	int width = tileMap->getWidth();
+	int col = index % width, row = index / width;
+	int count = 0;
+	if (parentIndex == index) {											// the start, look everywhere
+		int neighbours[8], costs[8];
+		int neighbourCount = getNeighbours(index, true, neighbours, costs);
+		for (int i = 0; i < neighbourCount; i++) {
+			directions[count][0] = neighbours[i] % width - col;
+			directions[count++][1] = neighbours[i] / width - row;
+		}
+		return count;
+	}
+	int dx = (index % width > parentIndex % width) - (index % width < parentIndex % width);
+	int dy = (index / width > parentIndex / width) - (index / width < parentIndex / width);
+	if (dx != 0 && dy != 0) {											// diagonal
+		bool verticalWalkable = walkable(col, row + dy);
+		bool horizontalWalkable = walkable(col + dx, row);
+		if (verticalWalkable) {
+			directions[count][0] = 0;
+			directions[count++][1] = dy;
+		}
+		if (horizontalWalkable) {
+			directions[count][0] = dx;
+			directions[count++][1] = 0;
+		}
+		if (verticalWalkable && horizontalWalkable) {
+			directions[count][0] = dx;
+			directions[count++][1] = dy;
+		}
+		return count;
+	}
+	bool nextWalkable = walkable(col + dx, row + dy);
+	if (nextWalkable) {
+		directions[count][0] = dx;
+		directions[count++][1] = dy;
+	}
+	for (int side = -1; side <= 1; side += 2) {
+		int sideX = dy != 0 ? side : 0, sideY = dx != 0 ? side : 0;	// perpendicular to the line
+		if (walkable(col + sideX, row + sideY) && !walkable(col + sideX - dx, row + sideY - dy)) {
+			directions[count][0] = sideX;
+			directions[count++][1] = sideY;
+			if (nextWalkable) {
+				directions[count][0] = dx + sideX;
+				directions[count++][1] = dy + sideY;
+			}
+		}
+	}
+	return count;
+}
+
+/*
+	finds the jump point a walk from a tile in a direction gets to: the goal, or a tile with a forced
+	neighbour (one only reachable optimally through this tile because of a solid tile beside the line).
+	Diagonal walks stop where a straight walk from the tile would find a jump point,
+	and before cutting the corner of a solid tile. The walks are looked up, see buildJumpDistances.
+	parameters:
+		col, row	- the first tile of the walk
+		dx, dy		- the direction of the walk, each -1, 0 or 1
+		goalIndex	- the goal of the search
+	returns the tile index of the jump point, -1 if the walk hits a solid tile or the edge of the map
+*/
+int PathFinder::jump(int col, int row, int dx, int dy, int goalIndex)
+{
+	int slot = dx == 0 ? (dy < 0 ? 0 : 1) : dy == 0 ? (dx < 0 ? 2 : 3) : 4 + (dy > 0) * 2 + (dx > 0);
+	return lookUpJump(col, row, dx, dy, slot, goalIndex);
+}
+
+/*
+	gets the directions the 4 connected JPS has to look in from a jump point (see jumpStraight)
+	parameters:
+		index		- the jump point
+		parentIndex	- the jump point it was reached from, itself for the start
+		directions	- set to the x and y of each direction, room for 4
+	returns the number of directions
+*/
+int PathFinder::getStraightJumpDirections(int index, int parentIndex, int directions[][2]) const
+{
+	int width = tileMap->getWidth();
+	int col = index % width, row = index / width;
+	int count = 0;
+	if (parentIndex == index) {											// the start, look everywhere
+		int neighbours[4], costs[4];
+		int neighbourCount = getNeighbours(index, false, neighbours, costs);
+		for (int i = 0; i < neighbourCount; i++) {
+			directions[count][0] = neighbours[i] % width - col;
+			directions[count++][1] = neighbours[i] / width - row;
+		}
+		return count;
+	}
+	int dx = (index % width > parentIndex % width) - (index % width < parentIndex % width);
+	int dy = (index / width > parentIndex / width) - (index / width < parentIndex / width);
+	if (dx != 0) {														// horizontal, on and up or down where a wall beside the row ends
+		if (walkable(col + dx, row)) {
+			directions[count][0] = dx;
+			directions[count++][1] = 0;
+		}
+		for (int side = -1; side <= 1; side += 2) {
+			if (walkable(col, row + side) && !walkable(col - dx, row + side)) {
+				directions[count][0] = 0;
+				directions[count++][1] = side;
+			}
+		}
+	}
+	else {																// vertical, on and to both sides
+		if (walkable(col, row + dy)) {
+			directions[count][0] = 0;
+			directions[count++][1] = dy;
+		}
+		for (int side = -1; side <= 1; side += 2) {
+			if (walkable(col + side, row)) {
+				directions[count][0] = side;
+				directions[count++][1] = 0;
+			}
+		}
+	}
+	return count;
+}
+
+/*
+	the jump of the 4 connected JPS, the vertical moves play the part the diagonal ones do on the
+	8 connected grid: a horizontal walk stops at the goal or where a wall above or below the row ends
+	(the tile past it can only be reached optimally from here), a vertical walk stops at the goal
+	or where a horizontal walk from the tile would find a jump point. Looked up, see buildJumpDistances.
+	parameters:
+		col, row	- the first tile of the walk
+		dx, dy		- the direction of the walk, one of them 0 and the other -1 or 1
+		goalIndex	- the goal of the search
+	returns the tile index of the jump point, -1 if the walk hits a solid tile or the edge of the map
+*/
+int PathFinder::jumpStraight(int col, int row, int dx, int dy, int goalIndex)
+{
+	int slot = dx != 0 ? (dx < 0 ? 2 : 3) : (dy < 0 ? 4 : 5);
+	return lookUpJump(col, row, dx, dy, slot, goalIndex);
+}
+
+/*
+	Jump Point Search, A* that only pushes jump points on the open list, the runs of open tiles
+	between them are jumped over in one look up each (see buildJumpDistances). With diagonal moves it's the 8 connected variant that never cuts corners (getJumpDirections, jump),
+	without them the 4 connected one (getStraightJumpDirections, jumpStraight), both find a shortest path.
+	Reference used:
+		Harabor, D., Grastien, A. (2011). Online Graph Pruning for Pathfinding on Grid Maps. AAAI.
+	returns true if the goal was reached, the jump points are in parent
+*/
+bool PathFinder::jumpPointSearch(int startIndex, int goalIndex, Direction preferredDirection)
+{
+	int width = tileMap->getWidth();
+	int preferredX = 0, preferredY = 0;
+	if (preferredDirection < DIRECTION_COUNT) {
+		preferredX = (int)Robot::directionTable[preferredDirection][0];
+		preferredY = (int)Robot::directionTable[preferredDirection][1];
+	}
+	int startCol = startIndex % width, startRow = startIndex / width;
+	int directions[8][2];
+	if (jumpVersion != tileMap->getVersion() || jumpDiagonal != allowDiagonal
+		|| openTiles.size() != (unsigned int)((tileMap->getWidth() + 2) * (tileMap->getHeight() + 2)))
+		buildJumpDistances();
+
+	open.clear();
+	visited[startIndex] = searchNumber;
+	cost[startIndex] = 0;
+	parent[startIndex] = startIndex;
+	int h = heuristic(startIndex, goalIndex, allowDiagonal);
+	open.push_back({ h, h, 0, startIndex });
+	while (!open.empty()) {
+		std::pop_heap(open.begin(), open.end(), worseNode);
+		OpenNode node = open.back();
+		open.pop_back();
+		if (closed[node.index] == searchNumber)
+			continue;													// stale entry, expanded already
+		closed[node.index] = searchNumber;
+		expandedTiles++;
+		if (node.index == goalIndex)
+			return true;
+		int col = node.index % width, row = node.index / width;
+		int directionCount = allowDiagonal
+			? getJumpDirections(node.index, parent[node.index], directions)
+			: getStraightJumpDirections(node.index, parent[node.index], directions);
+		for (int i = 0; i < directionCount; i++) {
+			int next = allowDiagonal
+				? jump(col + directions[i][0], row + directions[i][1], directions[i][0], directions[i][1], goalIndex)
+				: jumpStraight(col + directions[i][0], row + directions[i][1], directions[i][0], directions[i][1], goalIndex);
+			if (next == -1 || closed[next] == searchNumber)
+				continue;
+			int dx = abs(next % width - col), dy = abs(next / width - row);
+			int nextCost = cost[node.index] + STRAIGHT_COST * abs(dx - dy) + DIAGONAL_COST * std::min(dx, dy);
+			if (visited[next] != searchNumber || nextCost < cost[next]) {
+				visited[next] = searchNumber;
+				cost[next] = nextCost;
+				parent[next] = node.index;
+				h = heuristic(next, goalIndex, allowDiagonal);
+				int progress = (next % width - startCol) * preferredX + (next / width - startRow) * preferredY;
+				open.push_back({ nextCost + h, h, progress, next });
+				std::push_heap(open.begin(), open.end(), worseNode);
+			}
+		}
+	}
+	return false;
+}
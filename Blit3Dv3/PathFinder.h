@@ -0,0 +1,146 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <memory>
+#include "Direction.h"
+#include "DStarLite.h"
+#include "HierarchicalMap.h"
+#include "PathCache.h"
+
+class TileMap;
+
+// how the PathFinder searches
+enum class PathPlanner {
+	BFS,								// breadth-first, floods out from the start until it reaches the goal
+	ASTAR,								// A*, expands toward the goal first (Manhattan or octile distance)
+	JPS,								// Jump Point Search, A* that jumps over runs of open tiles
+	HPA,								// hierarchical A* on clusters of tiles, see HierarchicalMap
+	DSTAR,								// D* Lite, repairs the last path when tiles are edited, see DStarLite
+};
+
+/*
+	Finds shortest paths between tiles of a map, moving up, down, left and right around solid tiles,
+	and diagonally too if allowed (never cutting the corner of a solid tile).
+	Paths are always one waypoint per tile, whatever the planner.
+	Each robot owns one, the search buffers are reused between searches so after the first search
+	finding a path allocates nothing. Visited tiles are stamped with the number of the search
+	instead of a flag, so the buffers never need clearing.
+*/
+class PathFinder
+{
+private:
+	// an entry of the A* open list
+	struct OpenNode {
+		int f;									// cost so far + estimated cost to the goal
+		int h;									// estimated cost to the goal
+		int progress;							// tiles from the start along the preferred direction, for tie-breaking
+		int index;								// the tile
+	};
+	static const int STRAIGHT_COST = 10;		// step costs scaled by 10 so diagonals stay integers
+	static const int DIAGONAL_COST = 14;
+	// =========== DATA MEMBERS ==============
+	const TileMap* tileMap;						// the map to search, not owned
+	PathPlanner planner = PathPlanner::BFS;		// search algorithm
+	bool allowDiagonal = false;					// move diagonally too
+	std::vector<unsigned int> visited;			// search number that last visited each tile
+	std::vector<unsigned int> closed;			// search number that last expanded each tile, A* only
+	std::vector<int> parent;					// tile index each tile was reached from, valid when visited,
+												// for JPS the previous jump point on a straight or diagonal line
+	std::vector<int> cost;						// cost of the best path found to each tile, A* only
+	std::vector<int> queue;						// tiles to expand by the BFS, each tile is queued at most once per search
+	std::vector<OpenNode> open;					// A* open list, a binary heap
+	std::vector<int> component;					// connected area of each tile, -1 for solid tiles, see reachable
+	unsigned long long componentVersion = 0;	// map version the areas were labelled for, 0 for none yet
+	std::vector<unsigned char> openTiles;		// 1 for open tiles, with a border of solid ones, for buildJumpDistances
+	std::vector<int> jumpDistances;				// where the JPS walks from each tile stop, 8 per tile, see buildJumpDistances
+	unsigned long long jumpVersion = 0;			// map version the jump distances were built for, 0 for none yet
+	bool jumpDiagonal = false;					// the jump distances are for diagonal moves
+	HierarchicalMap hierarchy;					// clusters of the map for PathPlanner::HPA, built on the first search
+	DStarLite incremental;						// costs to the last goal for PathPlanner::DSTAR
+	std::shared_ptr<PathCache> cache;			// paths found before, may be shared with other path finders, null for none
+	unsigned int searchNumber = 0;				// number of the current search, stamps visited tiles
+	int expandedTiles = 0;						// tiles expanded by the last search, for JPS the jumps looked up too
+	long long totalExpandedTiles = 0;			// tiles expanded by all searches
+	long long searches = 0;						// number of searches
+	long long cacheHits = 0;					// searches answered by the cache
+	void prepare();
+	void labelComponents();
+	bool reachable(int startIndex, int goalIndex);
+	int getNeighbours(int index, bool diagonal, int neighbours[], int costs[]) const;
+	int heuristic(int index, int goalIndex, bool diagonal) const;
+	int segmentSteps(int from, int to) const;
+	bool walkable(int col, int row) const;
+	int jumpDistance(int col, int row, int slot) const;
+	void buildJumpDistances();
+	int lookUpJump(int col, int row, int dx, int dy, int slot, int goalIndex);
+	int getJumpDirections(int index, int parentIndex, int directions[][2]) const;
+	int jump(int col, int row, int dx, int dy, int goalIndex);
+	int getStraightJumpDirections(int index, int parentIndex, int directions[][2]) const;
+	int jumpStraight(int col, int row, int dx, int dy, int goalIndex);
+	static bool worseNode(const OpenNode& a, const OpenNode& b);
+	bool breadthFirst(int startIndex, int goalIndex);
+	bool aStar(int startIndex, int goalIndex, Direction preferredDirection);
+	bool jumpPointSearch(int startIndex, int goalIndex, Direction preferredDirection);
+	bool search(int startIndex, int goalIndex, std::vector<glm::vec2>& path, Direction preferredDirection);
+public:
+	// =========== FUNCTIONS ====================
+	// refer to cpp files for more detailed explanation
+	PathFinder(const TileMap* tileMap);
+	bool findPath(glm::vec2 start, glm::vec2 goal, std::vector<glm::vec2>& path,
+		Direction preferredDirection = NONE);
+	static const char* plannerName(PathPlanner planner);
+	static bool parsePlanner(std::string name, PathPlanner& planner);
+
+	// getters and setters
+	PathPlanner getPlanner() const {
+		return planner;
+	}
+
+	void setPlanner(PathPlanner planner) {
+		this->planner = planner;
+	}
+
+	bool getAllowDiagonal() const {
+		return allowDiagonal;
+	}
+
+	void setAllowDiagonal(bool allowDiagonal) {
+		this->allowDiagonal = allowDiagonal;
+		hierarchy.setAllowDiagonal(allowDiagonal);
+		incremental.setAllowDiagonal(allowDiagonal);
+	}
+
+	int getExpandedTiles() const {
+		return expandedTiles;
+	}
+
+	long long getTotalExpandedTiles() const {
+		return totalExpandedTiles;
+	}
+
+	long long getSearches() const {
+		return searches;
+	}
+
+	long long getCacheHits() const {
+		return cacheHits;
+	}
+
+	std::shared_ptr<PathCache> getCache() const {
+		return cache;
+	}
+
+	void setCache(std::shared_ptr<PathCache> cache) {
+		this->cache = cache;
+	}
+
+	// counts a search another path finder did for this one (see PlannerPool) in the statistics
+	void countSearch(int expandedTiles, bool cacheHit) {
+		this->expandedTiles = expandedTiles;
+		totalExpandedTiles += expandedTiles;
+		searches++;
+		if (cacheHit)
+			cacheHits++;
+	}
+};
@@ -0,0 +1,85 @@
+#include "PlannerPool.h"
+#include "TileMap.h"
+
+/*
+	Constructor, starts the worker threads
+	parameters:
+		threadCount	- number of worker threads, at least 1
+*/
+PlannerPool::PlannerPool(unsigned int threadCount)
+{
+	if (threadCount == 0)
+		threadCount = 1;
+	for (unsigned int i = 0; i < threadCount; i++) {
+		workers.push_back(std::thread(&PlannerPool::work, this));
+	}
+}
+
+/*
+	Destructor, finishes the requests already submitted and joins the workers
+*/
+PlannerPool::~PlannerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobAdded.notify_all();
+	for (unsigned int i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	}
+}
+
+/*
+	queues a search for the next free worker
+	parameters:
+		request		- the search, request.map must not be edited anymore
+	returns the future result, ready once a worker is done with it
+*/
+std::future<PlanResult> PlannerPool::submit(const PlanRequest& request)
+{
+	Job job;
+	job.request = request;
+	std::future<PlanResult> result = job.result.get_future();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	jobAdded.notify_one();
+	return result;
+}
+
+/*
+	body of a worker thread, takes the oldest request and searches it until the pool is destroyed
+*/
+void PlannerPool::work()
+{
+	std::shared_ptr<const TileMap> map;				// copy the path finder below searches
+	std::unique_ptr<PathFinder> pathFinder;
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			jobAdded.wait(lock, [this]() { return stopping || !jobs.empty(); });
+			if (jobs.empty())
+				return;										// stopping and nothing left to do
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		const PlanRequest& request = job.request;
+		if (request.map != map) {
+			map = request.map;
+			pathFinder.reset(new PathFinder(map.get()));
+		}
+		pathFinder->setPlanner(request.planner);
+		pathFinder->setAllowDiagonal(request.allowDiagonal);
+		pathFinder->setCache(request.cache);
+		long long cacheHits = pathFinder->getCacheHits();
+
+		PlanResult result;
+		result.found = pathFinder->findPath(request.start, request.goal, result.path, request.preferredDirection);
+		result.expandedTiles = pathFinder->getExpandedTiles();
+		result.cacheHit = pathFinder->getCacheHits() != cacheHits;
+		job.result.set_value(std::move(result));
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include "PathFinder.h"
+
+class TileMap;
+
+// a path search handed to a PlannerPool, same parameters as PathFinder::findPath
+struct PlanRequest {
+	std::shared_ptr<const TileMap> map;	// copy of the map to search, never edited once submitted
+	PathPlanner planner = PathPlanner::BFS;
+	bool allowDiagonal = false;
+	std::shared_ptr<PathCache> cache;	// shared with the robot's own PathFinder, null for none
+	glm::vec2 start;
+	glm::vec2 goal;
+	Direction preferredDirection = NONE;
+};
+
+// what a worker found for a PlanRequest
+struct PlanResult {
+	bool found = false;
+	std::vector<glm::vec2> path;		// tiles from start to goal, empty if not found
+	int expandedTiles = 0;
+	bool cacheHit = false;				// answered by the cache, no search
+};
+
+/*
+	Worker threads that search for paths while the simulation keeps ticking, so a long search
+	on a big map doesn't stall the fixed time step loop (or the frame of the windowed version).
+	submit returns a future of the result, the robot waits for it in RobotState::PLANNING.
+	The workers read a copy of the map taken when the request was made, the robot keeps mowing
+	and editing its own map meanwhile, a copy is reused by the requests of the same map version.
+	Each worker keeps a PathFinder on the last copy it searched so its buffers (and HPA's clusters)
+	are reused until the map changes. One pool can be shared by all the runs of a batch.
+*/
+class PlannerPool
+{
+private:
+	struct Job {
+		PlanRequest request;
+		std::promise<PlanResult> result;
+	};
+	// =========== DATA MEMBERS ==============
+	std::vector<std::thread> workers;
+	std::deque<Job> jobs;							// requests not taken by a worker yet, oldest first
+	std::mutex mutex;								// guards jobs and stopping
+	std::condition_variable jobAdded;
+	bool stopping = false;							// set by the destructor, workers quit once jobs is empty
+	void work();
+public:
+	// =========== FUNCTIONS ====================
+	// refer to cpp files for more detailed explanation
+	PlannerPool(unsigned int threadCount = 1);
+	~PlannerPool();
+	PlannerPool(const PlannerPool&) = delete;
+	PlannerPool& operator=(const PlannerPool&) = delete;
+	std::future<PlanResult> submit(const PlanRequest& request);
+
+	unsigned int getThreadCount() const {
+		return (unsigned int)workers.size();
+	}
+};
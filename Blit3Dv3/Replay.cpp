@@ -0,0 +1,186 @@
+#include "Replay.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+/*
+	writes a float in hexadecimal so it is read back with the exact same bits
+*/
+static std::string exactFloat(float value)
+{
+	std::ostringstream stream;
+	stream << std::hexfloat << (double)value;
+	return stream.str();
+}
+
+/*
+	reads a float written by exactFloat
+*/
+static float readExactFloat(std::istream& stream)
+{
+	std::string text;
+	stream >> text;
+	return (float)strtod(text.c_str(), NULL);
+}
+
+/*
+	saves a replay record to a text file, one "key value" pair per line
+	returns true if the file was written
+*/
+bool SaveReplay(std::string filename, const ReplayRecord& record)
+{
+	std::ofstream replayFile;
+	replayFile.open(filename);
+	if (!replayFile.is_open()) {
+		std::cout << "Can't open replay file!" << std::endl;
+		return false;
+	}
+	const SimulationSettings& settings = record.settings;
+	replayFile << "map " << record.mapFilename << std::endl;
+	if (!record.tilesetFilename.empty())
+		replayFile << "tileset " << record.tilesetFilename << std::endl;
+	replayFile << "strategy " << (settings.strategy == UpdateStrategy::BOUNCE ? "bounce"
+		: settings.strategy == UpdateStrategy::ROUTE ? "route" : "zigzag") << std::endl;
+	replayFile << "integration " << (settings.integrationMode == IntegrationMode::TICK ? "tick" : "segment") << std::endl;
+	replayFile << "collision " << (settings.collisionMode == CollisionMode::SAMPLED ? "sampled" : "swept") << std::endl;
+	replayFile << "kinematics " << (settings.kinematicsMode == KinematicsMode::FLOAT ? "float" : "fixed") << std::endl;
+	replayFile << "bounce " << Robot::bounceModeName(settings.bounceMode) << " " << settings.bounceCandidates << std::endl;
+	replayFile << "planner " << PathFinder::plannerName(settings.pathPlanner)
+		<< " " << (settings.allowDiagonal ? 1 : 0) << std::endl;
+	replayFile << "return " << (settings.chargerReturn == ChargerReturn::PERIMETER ? "perimeter" : "field") << std::endl;
+	replayFile << "resume " << (settings.resumeMode == ResumeMode::GOING_BACK ? "column" : "path") << std::endl;
+	replayFile << "route-legs " << exactFloat(settings.routeLegReserve) << std::endl;
+	replayFile << "planning-delay " << settings.planningDelay << std::endl;
+	replayFile << "time-slice " << exactFloat(settings.timeSlice) << std::endl;
+	replayFile << "start " << settings.startX << " " << settings.startY << std::endl;
+	replayFile << "seed " << settings.seed << " " << settings.stream << std::endl;
+	replayFile << "stuck-ticks " << settings.stuckTicks << std::endl;
+	replayFile << "max-ticks " << record.maxTicks << std::endl;
+	replayFile << "charge-curve " << settings.chargeCurve.size();
+	for (unsigned int i = 0; i < settings.chargeCurve.size(); i++) {
+		replayFile << " " << exactFloat(settings.chargeCurve[i].batteryLevel)
+			<< " " << exactFloat(settings.chargeCurve[i].rate);
+	}
+	replayFile << std::endl;
+	replayFile << "obstacles " << settings.obstacleEvents.size();
+	for (unsigned int i = 0; i < settings.obstacleEvents.size(); i++) {
+		const ObstacleEvent& event = settings.obstacleEvents[i];
+		replayFile << " " << event.tick << " " << event.row << " " << event.col << " " << event.foregroundTileNum;
+	}
+	replayFile << std::endl;
+	replayFile << "ticks " << record.ticks << std::endl;
+	replayFile << "hash " << std::hex << record.trajectoryHash << std::dec << std::endl;
+	return true;
+}
+
+/*
+	loads a replay record saved with SaveReplay
+	returns true if the file was read
+*/
+bool LoadReplay(std::string filename, ReplayRecord& record)
+{
+	std::ifstream replayFile;
+	replayFile.open(filename);
+	if (!replayFile.is_open()) {
+		std::cout << "Can't open replay file!" << std::endl;
+		return false;
+	}
+	record = ReplayRecord();
+	SimulationSettings& settings = record.settings;
+	settings.seeded = true;
+	std::string line, key, value;
+	while (std::getline(replayFile, line)) {
+		std::istringstream lineStream(line);
+		if (!(lineStream >> key))
+			continue;
+		if (key == "map") {
+			lineStream >> record.mapFilename;
+		}
+		else if (key == "tileset") {
+			lineStream >> record.tilesetFilename;
+		}
+		else if (key == "strategy") {
+			lineStream >> value;
+			settings.strategy = value == "bounce" ? UpdateStrategy::BOUNCE
+				: value == "route" ? UpdateStrategy::ROUTE : UpdateStrategy::ZIGZAG;
+		}
+		else if (key == "integration") {
+			lineStream >> value;
+			settings.integrationMode = value == "segment" ? IntegrationMode::SEGMENT : IntegrationMode::TICK;
+		}
+		else if (key == "collision") {
+			lineStream >> value;
+			settings.collisionMode = value == "swept" ? CollisionMode::SWEPT : CollisionMode::SAMPLED;
+		}
+		else if (key == "kinematics") {
+			lineStream >> value;
+			settings.kinematicsMode = value == "fixed" ? KinematicsMode::FIXED : KinematicsMode::FLOAT;
+		}
+		else if (key == "bounce") {
+			lineStream >> value >> settings.bounceCandidates;
+			Robot::parseBounceMode(value, settings.bounceMode);
+		}
+		else if (key == "planner") {
+			int allowDiagonal = 0;
+			lineStream >> value >> allowDiagonal;
+			PathFinder::parsePlanner(value, settings.pathPlanner);
+			settings.allowDiagonal = allowDiagonal != 0;
+		}
+		else if (key == "return") {
+			lineStream >> value;
+			settings.chargerReturn = value == "field" ? ChargerReturn::DISTANCE_FIELD : ChargerReturn::PERIMETER;
+		}
+		else if (key == "resume") {
+			lineStream >> value;
+			settings.resumeMode = value == "path" ? ResumeMode::SHORTEST_PATH : ResumeMode::GOING_BACK;
+		}
+		else if (key == "route-legs") {
+			settings.routeLegReserve = readExactFloat(lineStream);
+		}
+		else if (key == "planning-delay") {
+			lineStream >> settings.planningDelay;
+		}
+		else if (key == "time-slice") {
+			settings.timeSlice = readExactFloat(lineStream);
+		}
+		else if (key == "start") {
+			lineStream >> settings.startX >> settings.startY;
+		}
+		else if (key == "seed") {
+			lineStream >> settings.seed >> settings.stream;
+		}
+		else if (key == "stuck-ticks") {
+			lineStream >> settings.stuckTicks;
+		}
+		else if (key == "max-ticks") {
+			lineStream >> record.maxTicks;
+		}
+		else if (key == "charge-curve") {
+			unsigned int bands = 0;
+			lineStream >> bands;
+			for (unsigned int i = 0; i < bands; i++) {
+				ChargeCurveBand band;
+				band.batteryLevel = readExactFloat(lineStream);
+				band.rate = readExactFloat(lineStream);
+				settings.chargeCurve.push_back(band);
+			}
+		}
+		else if (key == "obstacles") {
+			unsigned int count = 0;
+			lineStream >> count;
+			for (unsigned int i = 0; i < count; i++) {
+				ObstacleEvent event;
+				lineStream >> event.tick >> event.row >> event.col >> event.foregroundTileNum;
+				settings.obstacleEvents.push_back(event);
+			}
+		}
+		else if (key == "ticks") {
+			lineStream >> record.ticks;
+		}
+		else if (key == "hash") {
+			lineStream >> std::hex >> record.trajectoryHash;
+		}
+	}
+	return !record.mapFilename.empty();
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+#include "Simulation.h"
+
+/*
+	Everything needed to replay a run bit for bit: the map, the seed and the settings,
+	plus the outcome of the original run to compare against
+*/
+struct ReplayRecord {
+	std::string mapFilename;
+	std::string tilesetFilename;				// empty for the default tileset
+	SimulationSettings settings;
+	long long maxTicks = 0;
+	long long ticks = 0;						// ticks of the recorded run
+	unsigned long long trajectoryHash = 0;		// trajectory hash of the recorded run
+};
+
+// refer to cpp file for more detailed explanation
+bool SaveReplay(std::string filename, const ReplayRecord& record);
+bool LoadReplay(std::string filename, ReplayRecord& record);
@@ -1,8 +1,11 @@
 #include "Robot.h"
 #include "TileMap.h"
-
-extern Blit3D* blit3D;
-extern TileMap* tileMap;
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#ifndef MOWER_HEADLESS
+#include "Blit3D.h"
+#endif
 
 // look up table for the x and y signs of a direction
 float Robot::directionTable[][2] = {
@@ -16,6 +19,21 @@ float Robot::directionTable[][2] = {
 	{ 0.f, 1.f },		// direction for DOWN
 };
 
+// sine of 0 to 90 degrees in 16384ths, round(16384 * sin(degrees)), the headings of KinematicsMode::FIXED
+// come from here instead of the math library, whose results can change with the build
+static const int QUARTER_SINE[91] = {
+	0, 286, 572, 857, 1143, 1428, 1713, 1997, 2280, 2563,
+	2845, 3126, 3406, 3686, 3964, 4240, 4516, 4790, 5063, 5334,
+	5604, 5872, 6138, 6402, 6664, 6924, 7182, 7438, 7692, 7943,
+	8192, 8438, 8682, 8923, 9162, 9397, 9630, 9860, 10087, 10311,
+	10531, 10749, 10963, 11174, 11381, 11585, 11786, 11982, 12176, 12365,
+	12551, 12733, 12911, 13085, 13255, 13421, 13583, 13741, 13894, 14044,
+	14189, 14330, 14466, 14598, 14726, 14849, 14968, 15082, 15191, 15296,
+	15396, 15491, 15582, 15668, 15749, 15826, 15897, 15964, 16026, 16083,
+	16135, 16182, 16225, 16262, 16294, 16322, 16344, 16362, 16374, 16382,
+	16384,
+};
+
 float Robot::SECONDS = 1.f;
 float Robot::MINUTES = 60.f;
 float Robot::HOURS = 3600.f;
@@ -23,20 +41,38 @@ float Robot::DISCHARGE_THRESHOLD = 2.f * Robot::HOURS;
 
 /*
 	constructor of the robot
+	parameters:
+		tileMap		- the map the robot mows, the robot does not own it
+		posX, posY	- starting tile of the robot
+		sprite		- sprite used by Draw, can be NULL for headless runs
 */
-Robot::Robot(int posX, int posY, Sprite* sprite, Direction initialDirection)
+Robot::Robot(TileMap* tileMap, int posX, int posY, Sprite* sprite, Direction initialDirection)
+	: pathFinder(tileMap)
 {
+	this->tileMap = tileMap;
 	this->sprite = sprite;
 	this->dir = initialDirection;
+	this->tile = glm::ivec2(posX, posY);
 	this->tileMapPosition = glm::vec2(posX, posY);
-	this->position = glm::vec2(posX * 16 + this->size, posY * 16 + this->size);
-	float screenXCenter = (((float) tileMap->getMapViewWidth() * 16.f) / 2.f) - this->size;
-	float screenYCenter = blit3D->screenHeight - (((float) tileMap->getMapViewHeight() * 16.f) / 2.f) + this->size;
-	this->screenPosition = glm::vec2(screenXCenter, screenYCenter);
+	this->prevTileMapPosition = this->tileMapPosition;
+	setPosition(glm::vec2(TileGrid::toPixel(posX) + this->size, TileGrid::toPixel(posY) + this->size));
+	this->screenPosition = glm::vec2(0, 0);
 	std::random_device rd;
 	rng.seed(rd());
 }
 
+/*
+	computes the screen position of the robot, the robot is always drawn at the center
+	of the map view (see TileMap::setMapView)
+*/
+void Robot::centerOnScreen(float screenHeight)
+{
+	float screenXCenter = (((float) tileMap->getMapViewWidth() * TileGrid::TILE_SIZE_F) / 2.f) - this->size;
+	float screenYCenter = screenHeight - (((float) tileMap->getMapViewHeight() * TileGrid::TILE_SIZE_F) / 2.f) + this->size;
+	this->screenPosition = glm::vec2(screenXCenter, screenYCenter);
+}
+
+#ifndef MOWER_HEADLESS
 /*
 	Draw the robot on the screen
 */
@@ -46,6 +82,7 @@ void Robot::Draw()
 		screenPosition.y,					// y axis in screen (0 is at bottom that's why we deduct the height)
 		0.04, 0.04);
 }
+#endif
 
 /*
 	Update the position of the robot based on the state
@@ -58,9 +95,11 @@ void Robot::Update(float seconds)
 	}
 	CollisionType colType;
 	if (state == RobotState::MOVING) {				// if robot is moving
-		move(seconds);								// update the position based on velocity and seconds
-		if ((colType = collisionCheck()) != CollisionType::NONE) {	// if colliding
-			revertPosition(seconds);								// revert position so it wouldn't clip
+		colType = moveAndCollide(seconds);			// update the position based on velocity and seconds
+		if (needsCharger(tileMapPosition, battery) && findChargerPath()) {	// head straight to a charger
+			followNewPath();
+		}
+		else if (colType != CollisionType::NONE) {					// if colliding
 			if (battery > 0  || (battery <= 0 
 				&& colType != CollisionType::PERIMETER)) {
 				bounce(seconds);									// update angle 
@@ -72,18 +111,20 @@ void Robot::Update(float seconds)
 			}
 		}
 	} else if (state == RobotState::LOOKUP_CHARGE_STN) {			// if state is looking for chargin station
-		if (tileMap->getTile(tileMapPosition.y, tileMapPosition.x).isChargingTile()) {		// if current position is a chargin tile
+		if (tileMap->isChargingTile(tileMapPosition.y, tileMapPosition.x)) {		// if current position is a chargin tile
 			velocity *= 0;																	// stop the robot
 			state = RobotState::CHARGING;													// set state as charging
-			position = glm::vec2(tileMapPosition.x * 16 + 8, tileMapPosition.y * 16 + 8);	// snap it to the center of the charging station
+			setPosition(glm::vec2(TileGrid::toPixel(tileMapPosition.x) + TileGrid::TILE_SIZE / 2, TileGrid::toPixel(tileMapPosition.y) + TileGrid::TILE_SIZE / 2));	// snap it to the center of the charging station
 		}
 		getDirectionAlongPerimeter(seconds);												// move along perimeter
 		move(seconds);																		// update position
 	}
+	else if (state == RobotState::FOLLOWING_PATH) {											// only paths to a charger here
+		followPath(seconds);
+	}
 	else if (state == RobotState::CHARGING) {												// if state is charging
 		if (battery <= 100) {
-			battery += 1;
-			timePassed += 1.f / 100.f * SECONDS;
+			chargeToFull(true);								// charge in one step and skip the charging ticks
 		}															
 		else {
 			rechargeCount++;
@@ -91,24 +132,108 @@ void Robot::Update(float seconds)
 		}
 	}
 	// set current position of robot to mowed, if it's mowable
-	if (tileMap->validMapPosition(tileMapPosition) 
-		&& tileMap->getTile(tileMapPosition.y, tileMapPosition.x).isMowableTile()) {
-		tileMap->mowTile(tileMapPosition.y, tileMapPosition.x);
-	}
+	mowCurrentTile();
 }
 
 /*
 	Updates the position of the robot based on velocity
+	with CollisionMode::SWEPT a step longer than a tile stops on the first tile the center enters,
+	the states that follow rows and paths react tile by tile.
+	With KinematicsMode::FIXED (sampled) it's an int add in 256ths of a pixel
 */
 void Robot::move(float seconds) {
-	position += velocity * seconds;
+	if (kinematicsMode == KinematicsMode::FIXED && collisionMode != CollisionMode::SWEPT) {
+		subpixelPosition += fixedStep(seconds);
+		position = glm::vec2(subpixelPosition) / (float)SUBPIXELS;
+		updateTileMapPosition();
+		return;
+	}
+	glm::vec2 displacement = tickStep(velocity, seconds);
+	if (collisionMode == CollisionMode::SWEPT) {
+		float time = 1.f;
+		int crossingAxis = -1;
+		for (int axis = 0; axis < 2; axis++) {
+			if (displacement[axis] == 0)
+				continue;
+			int tile = TileGrid::floorTile(position[axis]);
+			float boundary = (float)TileGrid::toPixel(displacement[axis] > 0 ? tile + 1 : tile);
+			float axisTime = (boundary - position[axis]) / displacement[axis];
+			if (axisTime < time) {
+				time = axisTime;
+				crossingAxis = axis;
+			}
+		}
+		if (crossingAxis != -1) {
+			displacement *= time;
+			displacement[crossingAxis] += displacement[crossingAxis] > 0 ? 0.01f : -0.01f;	// over the border
+		}
+	}
+	setPosition(position + displacement);
+	updateTileMapPosition();
+}
+
+/*
+	moves the robot in MOVING and checks if it ran into something, see CollisionMode
+	returns the collision type, the robot is left where it doesn't collide anymore
+*/
+CollisionType Robot::moveAndCollide(float seconds) {
+	if (collisionMode == CollisionMode::SWEPT)
+		return sweepMove(seconds);
+	move(seconds);
+	CollisionType colType = collisionCheck();
+	if (colType != CollisionType::NONE)
+		revertPosition(seconds);									// revert position so it wouldn't clip
+	return colType;
+}
+
+/*
+	moves the robot along its velocity up to the first solid tile its box touches (see TileMap::sweepBox)
+	and stops it right before, so the time step can be as long as we like without going through walls
+	returns the collision type of the tile, NONE if the robot made the whole move
+*/
+CollisionType Robot::sweepMove(float seconds) {
+	glm::vec2 displacement = velocity * seconds;
+	SweepHit hit;
+	tileMap->sweepBox(position, size, displacement, hit);
+	glm::vec2 target = position + displacement * hit.time;
+	if (hit.type != CollisionType::NONE)
+		target += hit.normal * 0.01f;								// off the tile, touching it counts as colliding
+	moveTo(target);
+	return hit.type;
+}
+
+/*
+	moves the robot in a straight line to target in steps no longer than its half size,
+	so the tiles the center goes through on a long move are entered (time and battery) and mowed
+	the same as they would be with short time steps
+*/
+void Robot::moveTo(glm::vec2 target) {
+	glm::vec2 start = position;
+	int steps = (int)std::ceil(glm::length(target - start) / size);
+	if (steps < 1)
+		steps = 1;
+	for (int i = 1; i <= steps; i++) {
+		setPosition(start + (target - start) * ((float)i / steps));
+		updateTileMapPosition();
+		mowCurrentTile();
+	}
+}
+
+/*
+	Updates the tile map position of the robot after its position changed,
+	time and battery are only spent when the robot moves to another tile
+*/
+void Robot::updateTileMapPosition() {
 	// record prev tileMapPosition
 	prevTileMapPosition = tileMapPosition;
-	// update tilemap position variable of robot
-	tileMapPosition = tileMap->toMapPosition(position);
-	bool robotDisplacement = tileMapPosition.x - prevTileMapPosition.x != 0 
-		|| tileMapPosition.y - prevTileMapPosition.y != 0;
+	// update the tile of the robot, rounded towards zero like TileMap::toMapPosition
+	glm::ivec2 newTile = kinematicsMode == KinematicsMode::FIXED
+		? glm::ivec2(subpixelTile(subpixelPosition.x), subpixelTile(subpixelPosition.y))
+		: glm::ivec2(TileGrid::toTile((int)position.x), TileGrid::toTile((int)position.y));
+	bool robotDisplacement = newTile != tile;
 	if (robotDisplacement) {
+		tile = newTile;
+		tileMapPosition = glm::vec2(tile);
 		timePassed += SECONDS / HOURS;
 		if (battery > 0)
 			battery -= (SECONDS / DISCHARGE_THRESHOLD) * 100.f;				// update battery
@@ -116,6 +241,99 @@ void Robot::move(float seconds) {
 			battery = 0;
 	}
 }
+
+/*
+	mows the tile the robot is on, if it's mowable
+*/
+void Robot::mowCurrentTile() {
+	if (tileMap->validMapPosition(tileMapPosition)
+		&& tileMap->isMowableTile(tileMapPosition.y, tileMapPosition.x)) {
+		tileMap->mowTile(tileMapPosition.y, tileMapPosition.x);
+	}
+}
+/*
+	returns the charge rate, in % per tick, for the given battery level
+	without a charge curve the robot charges 1% per tick
+*/
+float Robot::chargeRateAt(float battery) {
+	if (chargeCurve.empty())
+		return 1.f;
+	float rate = chargeCurve[0].rate;
+	for (unsigned int i = 0; i < chargeCurve.size(); i++) {
+		if (battery >= chargeCurve[i].batteryLevel)
+			rate = chargeCurve[i].rate;
+	}
+	return rate;
+}
+
+/*
+	Closed form charging, computes band by band of the charge curve how many ticks of charging
+	it takes to fill the battery, ceil(deficit / rate) ticks per band, and charges in one step.
+	The tick it is called on is the first charging tick, the others are left in pendingIdleTicks
+	for skipIdleTicks, so the robot resumes on the tick after the last one.
+	NOTE: battery and time are one multiply per band instead of a float add per tick of charging,
+	so they differ from adding them up tick by tick in the last bits of the float, and with a
+	fractional rate the battery can land a tick later on the end of a band.
+	parameters:
+		inclusive	- true if the robot keeps charging while battery <= 100 (Update),
+					  false if it stops charging when battery reaches 100 (Update2)
+*/
+void Robot::chargeToFull(bool inclusive) {
+	const float FULL_BATTERY = 100.f;
+	long long ticks = 0;
+	while (inclusive ? battery <= FULL_BATTERY : battery < FULL_BATTERY) {
+		float rate = chargeRateAt(battery);
+		// find where the current band of the charge curve ends
+		float bandEnd = FULL_BATTERY;
+		for (unsigned int i = 0; i < chargeCurve.size(); i++) {
+			if (chargeCurve[i].batteryLevel > battery && chargeCurve[i].batteryLevel < bandEnd)
+				bandEnd = chargeCurve[i].batteryLevel;
+		}
+		long long bandTicks;
+		if (bandEnd == FULL_BATTERY && inclusive)
+			bandTicks = (long long)floor((bandEnd - battery) / rate) + 1;	// until the battery goes over 100
+		else
+			bandTicks = (long long)ceil((bandEnd - battery) / rate);		// until the battery reaches the end of the band
+		if (bandTicks < 1)
+			bandTicks = 1;
+		battery += bandTicks * rate;
+		ticks += bandTicks;
+	}
+	timePassed += ticks * (1.f / 100.f * SECONDS);
+	if (ticks > 1)
+		pendingIdleTicks += ticks - 1;
+}
+
+/*
+	loads a charge curve from a file, each line has a battery level and the charge rate (% per tick)
+	from that level up, e.g.
+		0 2
+		80 0.5
+	parameters:
+		filename	- file to load
+		chargeCurve	- receives the bands of the curve
+	returns true if the file was loaded, false if it can't be opened or is invalid
+*/
+bool Robot::LoadChargeCurve(std::string filename, std::vector<ChargeCurveBand>& chargeCurve) {
+	std::ifstream curveFile;
+	curveFile.open(filename);
+	if (!curveFile.is_open()) {
+		std::cout << "Can't open charge curve file!" << std::endl;
+		return false;
+	}
+	std::vector<ChargeCurveBand> bands;
+	ChargeCurveBand band;
+	while (curveFile >> band.batteryLevel >> band.rate) {
+		if (band.rate <= 0 || (!bands.empty() && band.batteryLevel <= bands.back().batteryLevel)) {
+			std::cout << "Invalid charge curve, rates must be positive and levels increasing!" << std::endl;
+			return false;
+		}
+		bands.push_back(band);
+	}
+	chargeCurve = bands;
+	return true;
+}
+
 /*
 	make robot move along the perimeter,
 	computes the next velocity (direction)
@@ -147,11 +365,15 @@ void Robot::getDirectionAlongPerimeter(float seconds) {
 		nextDirectionIndexY = tileMapPosition.y + directionTable[currPerimeterDirection][1];
 		// if next direction tile will collide or next position has no perimeter adjacent, 
 		// or next direction is not adjacent/same with previous perimeter tile robot should stop
-		if (!tileMap->hasPerimeterAdjacent(glm::vec2(nextDirectionIndexY, nextDirectionIndexX)) ||
-			lookAheadCollision(3, velocity, seconds)) {
-			position = glm::vec2(tileMapPosition.x * 16 + size, tileMapPosition.y * 16 + size);
+		// (a swept step goes all the way to the next tile, so it's checked before the look-ahead gets there)
+		if (!tileMap->hasPerimeterAdjacent(glm::vec2(nextDirectionIndexX, nextDirectionIndexY)) ||
+			lookAheadCollision(3, velocity, seconds) ||
+			(collisionMode == CollisionMode::SWEPT && tileMap->isSolid(nextDirectionIndexY, nextDirectionIndexX))) {
+			setPosition(glm::vec2(TileGrid::toPixel(tileMapPosition.x) + size, TileGrid::toPixel(tileMapPosition.y) + size));
 			velocity *= 0;
+#ifndef MOWER_HEADLESS
 			std::cout << "looking for next position" << std::endl;
+#endif
 			prevPerimeterDirection = currPerimeterDirection;
 			currPerimeterDirection = NONE;
 		}
@@ -195,6 +417,10 @@ void Robot::getValidMoveAlongDirections(glm::vec2 tileMapPosition, bool result[]
 		Direction::LEFT,
 		Direction::RIGHT,
 	};
+	if (!tileMap->validMapPosition(tileMapPosition))
+		return;
+	// perimeter neighbours of the current tile, tells which next tiles are perimeter tiles
+	unsigned char perimeterNeighbours = tileMap->getPerimeterNeighbours(tileMapPosition.y, tileMapPosition.x);
 	// declare variables used within the loop
 	int directionsIndex, nextDirectionIndexX, nextDirectionIndexY;
 	Direction currDirection;
@@ -202,9 +428,9 @@ void Robot::getValidMoveAlongDirections(glm::vec2 tileMapPosition, bool result[]
 		currDirection = lookAheadDir[directionsIndex];					
 		nextDirectionIndexX = tileMapPosition.x + directionTable[currDirection][0];					// get next X map index for direction
 		nextDirectionIndexY = tileMapPosition.y + directionTable[currDirection][1];					// get next Y map index next direction
-		if (tileMap->validMapPosition(glm::vec2(nextDirectionIndexY, nextDirectionIndexX)) &&		// if next tile is valid
-			tileMap->getTile(nextDirectionIndexY, nextDirectionIndexX).tileCollisionType() != CollisionType::PERIMETER && // if next tile is not perimeter
-			tileMap->hasPerimeterAdjacent(glm::vec2(nextDirectionIndexY, nextDirectionIndexX))) {	// and next tile has a perimeter beside it
+		if (tileMap->validMapPosition(nextDirectionIndexX, nextDirectionIndexY) &&					// if next tile is valid
+			!(perimeterNeighbours & TileMap::neighbourBit(currDirection)) &&						// if next tile is not perimeter
+			tileMap->getPerimeterNeighbours(nextDirectionIndexY, nextDirectionIndexX) != 0) {		// and next tile has a perimeter beside it
 			result[directionsIndex] = true;															// set index of resulting array as true (marking the direction as a valid one)
 		}
 	}
@@ -214,85 +440,229 @@ void Robot::getValidMoveAlongDirections(glm::vec2 tileMapPosition, bool result[]
 	returns the collision type of the robot
 */
 CollisionType Robot::collisionCheck() {
+	// tiles of the 4 corners of the robot, rounded towards zero like TileMap::toMapPosition
+	int upRow, downRow, leftCol, rightCol;
+	if (kinematicsMode == KinematicsMode::FIXED) {
+		int halfSize = (int)(size * SUBPIXELS);
+		upRow = subpixelTile(subpixelPosition.y + halfSize);
+		downRow = subpixelTile(subpixelPosition.y - halfSize);
+		leftCol = subpixelTile(subpixelPosition.x - halfSize);
+		rightCol = subpixelTile(subpixelPosition.x + halfSize);
+	}
+	else {
+		upRow = TileGrid::toTile((int)(position.y + size));
+		downRow = TileGrid::toTile((int)(position.y - size));
+		leftCol = TileGrid::toTile((int)(position.x - size));
+		rightCol = TileGrid::toTile((int)(position.x + size));
+	}
 
-	bool upLeftTileCollided, upRightTileCollided, downRightTileCollided, downLeftTileCollided, currentTileCollided;
-	// get the 4 corner points of the robot
-	float up = position.y + size;
-	float down = position.y - size;
-	float left = position.x - size;
-	float right = position.x + size;
-
-	// convert pixel coordinates into tile coordinates
-	glm::vec2 upLeftTilePos = tileMap->toMapPosition(glm::vec2(up, left));
-	glm::vec2 upRightTilePos = tileMap->toMapPosition(glm::vec2(up, right));
-	glm::vec2 downLeftTilePos = tileMap->toMapPosition(glm::vec2(down, left));
-	glm::vec2 downRightTilePos = tileMap->toMapPosition(glm::vec2(down, right));
-
-	if (tileMap->validMapPosition(upLeftTilePos)) {
-		Tile upLeftTile = tileMap->getTile(upLeftTilePos.x, upLeftTilePos.y);
-		upLeftTileCollided = upLeftTile.tileCollisionType() != CollisionType::NONE;
-		if (upLeftTileCollided) return upLeftTile.tileCollisionType();
-	}
-	if (tileMap->validMapPosition(upRightTilePos)) {
-		Tile upRightTile = tileMap->getTile(upRightTilePos.x, upRightTilePos.y);
-		upRightTileCollided = upRightTile.tileCollisionType() != CollisionType::NONE;
-		if (upRightTileCollided) return upRightTile.tileCollisionType();
-	}
-	if (tileMap->validMapPosition(downRightTilePos)) {
-		Tile downRightTile = tileMap->getTile(downRightTilePos.x, downRightTilePos.y);
-		downRightTileCollided = downRightTile.tileCollisionType() != CollisionType::NONE;
-		if (downRightTileCollided) return downRightTile.tileCollisionType();
-	}
-	if (tileMap->validMapPosition(downLeftTilePos)) {
-		Tile downLeftTile = tileMap->getTile(downLeftTilePos.x, downLeftTilePos.y);
-		downLeftTileCollided = downLeftTile.tileCollisionType() != CollisionType::NONE;
-		if (downLeftTileCollided) return downLeftTile.tileCollisionType();
-	}
-	if (tileMap->validMapPosition(tileMapPosition.y, tileMapPosition.x)) {
-		Tile currTile = tileMap->getTile(tileMapPosition.y, tileMapPosition.x);
-		currentTileCollided = currTile.tileCollisionType() != CollisionType::NONE;
-		if (currentTileCollided) return currTile.tileCollisionType();
+	// up left, up right, down right and down left
+	const int cornerRows[4] = { upRow, upRow, downRow, downRow };
+	const int cornerCols[4] = { leftCol, rightCol, rightCol, leftCol };
+	for (int i = 0; i < 4; i++) {
+		if (tileMap->validMapPosition(cornerCols[i], cornerRows[i])) {
+			CollisionType cornerCollision = tileMap->collisionType(cornerRows[i], cornerCols[i]);
+			if (cornerCollision != CollisionType::NONE) return cornerCollision;
+		}
+	}
+	if (tileMap->validMapPosition(tileMapPosition)) {
+		CollisionType currTileCollision = tileMap->collisionType(tileMapPosition.y, tileMapPosition.x);
+		if (currTileCollision != CollisionType::NONE) return currTileCollision;
 	}
 
 	// return none if not collided
 	return CollisionType::NONE;
 }
+/*
+	seeds the rng of the robot, robots with the same seed and stream make the same choices.
+	parallel runs should share the seed and use a different stream each, std::seed_seq
+	mixes both into the whole mt19937 state so the streams don't overlap in practice.
+*/
+void Robot::setSeed(unsigned long long seed, unsigned long long stream) {
+	std::seed_seq seedSequence = {
+		(unsigned int)(seed & 0xFFFFFFFFu), (unsigned int)(seed >> 32),
+		(unsigned int)(stream & 0xFFFFFFFFu), (unsigned int)(stream >> 32)
+	};
+	rng.seed(seedSequence);
+}
+
+/*
+	returns a random int from min to max (inclusive).
+	std::uniform_int_distribution is implemented differently by each standard library,
+	this maps the mt19937 output the same way everywhere so seeded runs replay bit for bit
+*/
+int Robot::randomInt(int min, int max) {
+	unsigned long long range = (unsigned long long)(max - min) + 1;
+	unsigned long long limit = (0x100000000ull / range) * range;	// reject the values that would bias the modulo
+	unsigned long long value;
+	do {
+		value = rng();
+	} while (value >= limit);
+	return min + (int)(value % range);
+}
+
 /**
 	bounce function when robot is colliding with obstacles/perimeter,
 	changes the velocity of the robot based on the computed angles
 */
 void Robot::bounce(float seconds) {
+	if (bounceMode != BounceMode::RANDOM && bounceToBestHeading())
+		return;
 	glm::vec2 tempVelocity;											// record temp velocity
-	std::uniform_int_distribution<int> zeroToOne(0, 1);				
-	std::uniform_int_distribution<int> range30(-15, 15);			// rng from -15 to 15, used for future angles
-	int zeroOrOne = zeroToOne(rng);									// roll from 0 to 1
-	float currentRadians = glm::atan(velocity.y, velocity.x);		
-	float currentDegree = glm::degrees(currentRadians);				// get current angle of robot
-	int firstAngleChoice = (120 + range30(rng)) + currentDegree;	// possible angle 120 +- 15 to left
-	int secondAngleChoice = currentDegree - (120 + range30(rng));	// possible angle 120 +- 15 to right
+	int zeroOrOne = randomInt(0, 1);								// roll from 0 to 1
+	float currentDegree = kinematicsMode == KinematicsMode::FIXED	// get current angle of robot
+		? (float)headingDegrees(velocity)
+		: glm::degrees(glm::atan(velocity.y, velocity.x));
+	int firstAngleChoice = (120 + randomInt(-15, 15)) + currentDegree;	// possible angle 120 +- 15 to left
+	int secondAngleChoice = currentDegree - (120 + randomInt(-15, 15));	// possible angle 120 +- 15 to right
 	float bounceDegree = zeroOrOne == 0								// assign tentative angle of choice based on 0 or 1
 		? firstAngleChoice
 		: secondAngleChoice;
-	float bounceRadians = glm::radians(bounceDegree);
-	tempVelocity.x = speed * cos(bounceRadians);
-	tempVelocity.y = speed * sin(bounceRadians);					// compute temporary velocity based on tentative angle
+	tempVelocity = headingVelocity(bounceDegree);					// compute temporary velocity based on tentative angle
 	// look at 10 ticks ahead if projected trajectory has no obstacle!
 	// if there is, use the other angle instead
 	if (lookAheadCollision(10, tempVelocity, seconds)) {			// check if temporary velocity will collide  right away on the next tile
 		bounceDegree = zeroOrOne == 0								// if it does, use the other angle instead.
 			? secondAngleChoice
 			: firstAngleChoice;
-		bounceRadians = glm::radians(bounceDegree);
-		velocity.x = speed * cos(bounceRadians);
-		velocity.y = speed * sin(bounceRadians);
+		velocity = headingVelocity(bounceDegree);
 	}
 	else {
 		velocity = tempVelocity;									// else temp velocity to current robot
 	}
 }
 
+/*
+	returns the velocity of the robot heading the given angle, in degrees, with KinematicsMode::FIXED
+	the angle is rounded down to a whole degree and looked up in the sine table
+*/
+glm::vec2 Robot::headingVelocity(float degrees) {
+	if (kinematicsMode == KinematicsMode::FIXED)
+		return speed * headingVector((int)std::floor(degrees));
+	float radians = glm::radians(degrees);
+	return glm::vec2(speed * cos(radians), speed * sin(radians));
+}
+
+/*
+	returns the unit vector of a heading in whole degrees, off the sine table
+*/
+glm::vec2 Robot::headingVector(int degrees) {
+	int sines[2];
+	for (int i = 0; i < 2; i++) {
+		int angle = ((degrees + (i == 0 ? 90 : 0)) % 360 + 360) % 360;		// cosine is the sine 90 degrees on
+		int quarterAngle = angle % 180 <= 90 ? angle % 180 : 180 - angle % 180;
+		sines[i] = angle < 180 ? QUARTER_SINE[quarterAngle] : -QUARTER_SINE[quarterAngle];
+	}
+	return glm::vec2((float)sines[0], (float)sines[1]) / 16384.f;
+}
+
+/*
+	returns the whole degree, 0 to 359, closest to the heading of a vector (0 for a zero vector), as far as
+	the table can tell: headings within a tenth of a degree of a half degree may go either way.
+	The steepness of the vector is searched in the first quarter of the sine table, the products of a float
+	and a table entry are exact in a double, so the comparisons come out the same on any build.
+*/
+int Robot::headingDegrees(glm::vec2 vector) {
+	double x = fabs((double)vector.x), y = fabs((double)vector.y);
+	int low = 0, high = 90;											// first degree at least as steep as the vector
+	while (low < high) {
+		int middle = (low + high) / 2;
+		if (QUARTER_SINE[middle] * x >= QUARTER_SINE[90 - middle] * y)
+			high = middle;
+		else
+			low = middle + 1;
+	}
+	// or the one before it, whichever points closer to the vector
+	if (low > 0 && QUARTER_SINE[91 - low] * x + QUARTER_SINE[low - 1] * y > QUARTER_SINE[90 - low] * x + QUARTER_SINE[low] * y)
+		low--;
+	int degrees = vector.x < 0 ? 180 - low : low;
+	if (vector.y < 0)
+		degrees = -degrees;
+	return (degrees + 360) % 360;
+}
+
+/*
+	returns the name of a bounce mode, as used on the command line and in replay files
+*/
+const char* Robot::bounceModeName(BounceMode mode) {
+	switch (mode) {
+	case BounceMode::MOST_UNMOWED:
+		return "unmowed";
+	default:
+		return "random";
+	}
+}
+
+/*
+	reads a bounce mode name written by bounceModeName
+	returns false if the name isn't a bounce mode
+*/
+bool Robot::parseBounceMode(std::string name, BounceMode& mode) {
+	const BounceMode modes[] = { BounceMode::RANDOM, BounceMode::MOST_UNMOWED };
+	for (unsigned int i = 0; i < 2; i++) {
+		if (name == bounceModeName(modes[i])) {
+			mode = modes[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+	bounces by weighing a fan of headings instead of trying two at random: bounceCandidates headings evenly
+	spread over the 240 degrees facing away from where the robot was going (the fan is turned by a random
+	fraction of its spacing every bounce so the robot doesn't repeat itself), the one going over the most
+	unmowed tiles wins, then the one with the longest way to go. Ties go to the first heading of the fan.
+	The robot's box is swept along a heading for the way it can go (see TileMap::sweepBox), then its
+	center, which is what mows, is cast that far for the unmowed tiles on the way (see TileMap::raycast).
+	returns false, leaving the velocity alone, if none of the headings goes over an unmowed tile, the
+	longest way across mowed grass sends the robot back and forth over it, a random bounce does better
+*/
+bool Robot::bounceToBestHeading() {
+	const float BOUNCE_RANGE = 20 * TileGrid::TILE_SIZE_F;							// how far the headings are looked at, in pixels
+	const float FAN_START = 60.f, FAN_WIDTH = 240.f;				// degrees from the current heading
+	bool fixed = kinematicsMode == KinematicsMode::FIXED;
+	float currentDegree = fixed
+		? (float)headingDegrees(velocity)
+		: glm::degrees(glm::atan(velocity.y, velocity.x));
+	int offsetPercent = randomInt(0, 99);
+	float offset = (float)offsetPercent / 100.f;
+	glm::vec2 bestDirection;
+	float bestRun = -1;
+	int bestUnmowed = -1;
+	for (int i = 0; i < bounceCandidates; i++) {
+		glm::vec2 direction;
+		if (fixed) {												// whole degrees off the sine table
+			int degrees = (int)currentDegree + (int)FAN_START
+				+ (int)FAN_WIDTH * (100 * i + offsetPercent) / (100 * bounceCandidates);
+			direction = headingVector(degrees);
+		}
+		else {
+			float radians = glm::radians(currentDegree + FAN_START + FAN_WIDTH * ((float)i + offset) / bounceCandidates);
+			direction = glm::vec2(cos(radians), sin(radians));
+		}
+		SweepHit sweep;
+		tileMap->sweepBox(position, size, direction * BOUNCE_RANGE, sweep);
+		float run = sweep.time * BOUNCE_RANGE;
+		RayHit ray;
+		tileMap->raycast(position, direction, run, ray);
+		if (ray.mowableTiles > bestUnmowed || (ray.mowableTiles == bestUnmowed && run > bestRun)) {
+			bestDirection = direction;
+			bestRun = run;
+			bestUnmowed = ray.mowableTiles;
+		}
+	}
+	if (bestUnmowed <= 0)
+		return false;
+	velocity = speed * bestDirection;
+	return true;
+}
+
 /*
 	looks ahead for a given amount of ticks, 
+	with CollisionMode::SWEPT the center is cast along the whole distance (see TileMap::raycast), every tile on
+	the way is checked instead of one point per tick, and the distance is what the ticks cover at
+	a 100th of a second, so a long time step doesn't make the robot look further
 	returns			- TRUE if the robot will collide in the future, FALSE if not
 	parameters:
 		ticks		- the number of ticks for look ahead
@@ -300,11 +670,25 @@ void Robot::bounce(float seconds) {
 		seconds		- delta time
 */
 bool Robot::lookAheadCollision(int ticks, glm::vec2 velocity, float seconds) {
+	if (collisionMode == CollisionMode::SWEPT) {
+		RayHit hit;
+		return tileMap->raycast(position, velocity, (float)ticks * glm::length(velocity) / 100.f, hit);
+	}
 	glm::vec2 futurePosition, futureTile;
-	for (unsigned int i = 1; i <= ticks; i++) {									// for i to tick
-		futurePosition = position + ((float)i * velocity * seconds);	// compute future position based on velocity and time given
-		futureTile = tileMap->toMapPosition(futurePosition);			// compute position to tile
-		if (tileMap->getTile(futureTile.y, futureTile.x).tileCollisionType() != CollisionType::NONE) {
+	glm::ivec2 subpixelStep = kinematicsMode == KinematicsMode::FIXED	// see fixedStep
+		? toSubpixels(velocity * seconds)
+		: glm::ivec2(0, 0);
+	for (int i = 1; i <= ticks; i++) {									// for i to tick
+		if (kinematicsMode == KinematicsMode::FIXED) {					// compute future tile based on velocity and time given
+			glm::ivec2 futureSubpixels = subpixelPosition + i * subpixelStep;
+			futureTile = glm::vec2(subpixelTile(futureSubpixels.x), subpixelTile(futureSubpixels.y));
+		}
+		else {
+			futurePosition = position + ((float)i * velocity * seconds);
+			futureTile = tileMap->toMapPosition(futurePosition);		// compute position to tile
+		}
+		if (!tileMap->validMapPosition(futureTile)						// leaving the map counts as a collision
+			|| tileMap->isSolid(futureTile.y, futureTile.x)) {
 			return true;												// return true if robot will collide -- collision type for the tile is not NONE
 		}
 	}
@@ -317,11 +701,254 @@ bool Robot::lookAheadCollision(int ticks, glm::vec2 velocity, float seconds) {
 	(so bounce wouldn't be called too many times)
 */ 
 void Robot::revertPosition(float seconds) {
-	position -= velocity * seconds * 1.5f; // 1.2 means as an offset just in case the robot clips.
+	if (kinematicsMode == KinematicsMode::FIXED) {
+		glm::ivec2 step = fixedStep(seconds);
+		for (int axis = 0; axis < 2; axis++)						// 1.5 steps, halves rounded away from zero
+			subpixelPosition[axis] -= (3 * step[axis] + (step[axis] > 0) - (step[axis] < 0)) / 2;
+		position = glm::vec2(subpixelPosition) / (float)SUBPIXELS;
+	}
+	else
+		position -= velocity * seconds * 1.5f; // 1.2 means as an offset just in case the robot clips.
+}
+
+/*
+	returns the displacement of the robot over one tick, in pixels.
+	With KinematicsMode::FIXED it's rounded to a 256th of a pixel, the same step as fixedStep
+*/
+glm::vec2 Robot::tickStep(glm::vec2 velocity, float seconds) {
+	glm::vec2 step = velocity * seconds;
+	if (kinematicsMode == KinematicsMode::FIXED)
+		step = toSubpixelGrid(step);
+	return step;
+}
+
+/*
+	returns the displacement of the robot over one tick with KinematicsMode::FIXED, in 256ths of a pixel.
+	The robot's position is an int count of 256ths (subpixelPosition), a tick adds this step to it,
+	so nothing is left for the compiler's choices (fused multiply-add, extended precision) to round
+	differently, and a jump over n ticks (skipIdleTicks) lands exactly where n ticks would.
+	The velocity is only rounded again when it changed since the last tick.
+*/
+glm::ivec2 Robot::fixedStep(float seconds) {
+	if (velocity != roundedVelocity || seconds != roundedSeconds) {
+		subpixelVelocity = toSubpixels(velocity * seconds);
+		roundedVelocity = velocity;
+		roundedSeconds = seconds;
+	}
+	return subpixelVelocity;
+}
+
+/*
+	rounds a vector, in pixels, to the nearest 256th of a pixel
+*/
+glm::vec2 Robot::toSubpixelGrid(glm::vec2 vector) {
+	return glm::vec2(toSubpixels(vector)) / (float)SUBPIXELS;
+}
+
+/*
+	returns a vector in pixels as a whole number of 256ths of a pixel, rounded to the nearest
+*/
+glm::ivec2 Robot::toSubpixels(glm::vec2 pixels) {
+	return glm::ivec2((int)std::round(pixels.x * SUBPIXELS), (int)std::round(pixels.y * SUBPIXELS));
+}
+
+/*
+	returns the tile of a coordinate in 256ths of a pixel, rounded towards zero like TileMap::toMapPosition
+*/
+int Robot::subpixelTile(int subpixels) {
+	return TileGrid::toTile(subpixels / SUBPIXELS);
+}
+
+/*
+	puts the robot at a position, in pixels. With KinematicsMode::FIXED the position is rounded
+	to a 256th of a pixel, where the robot stays (the tile centers it snaps to are already on it)
+*/
+void Robot::setPosition(glm::vec2 pixels) {
+	if (kinematicsMode == KinematicsMode::FIXED) {
+		subpixelPosition = toSubpixels(pixels);
+		pixels = glm::vec2(subpixelPosition) / (float)SUBPIXELS;
+	}
+	position = pixels;
+}
+
+/*
+	puts the robot a number of ticks along a straight line, with KinematicsMode::FIXED in ints
+	parameters:
+		start			- position of the robot at tick 0, in pixels
+		subpixelStart	- the same in 256ths of a pixel, KinematicsMode::FIXED only
+		step			- displacement of the robot per tick, in pixels (fixedStep with KinematicsMode::FIXED)
+		ticks			- ticks from the start
+*/
+void Robot::placeOnLine(glm::vec2 start, glm::ivec2 subpixelStart, glm::vec2 step, long long ticks) {
+	if (kinematicsMode == KinematicsMode::FIXED) {
+		subpixelPosition = subpixelStart + (int)ticks * subpixelVelocity;
+		position = glm::vec2(subpixelPosition) / (float)SUBPIXELS;
+	}
+	else
+		position = start + (float)ticks * step;
+}
+
+/*
+	finds the first tick after fromTick at which a point of the robot, moving in a straight line, enters another tile
+	parameters:
+		start		- position of the robot at tick 0
+		step		- displacement of the robot per tick
+		fromTick	- tick to search from
+		axis		- 0 for the x axis, 1 for the y axis
+		offset		- offset of the point from the center of the robot along the axis
+		limit		- last tick to look at
+	returns the tick, or limit + 1 if the point stays on the same tile until limit
+*/
+long long Robot::ticksToTileChange(glm::vec2 start, glm::vec2 step, long long fromTick, int axis, float offset, long long limit) {
+	if (step[axis] == 0 || fromTick >= limit)
+		return limit + 1;
+	float coordinate = start[axis] + (float)fromTick * step[axis] + offset;
+	int tile = TileGrid::toTile((int)coordinate);
+	float boundary = (float)TileGrid::toPixel(step[axis] > 0 ? tile + 1 : tile);
+	double estimate = fromTick + (boundary - coordinate) / step[axis];
+	long long tick = estimate > (double)limit ? limit + 1 : (long long)estimate;
+	if (tick <= fromTick)
+		tick = fromTick + 1;
+	// the float estimate can be off by a tick, fix it with the actual positions
+	while (tick > fromTick + 1 && TileGrid::toTile((int)(start[axis] + (float)(tick - 1) * step[axis] + offset)) != tile)
+		tick--;
+	while (tick <= limit && TileGrid::toTile((int)(start[axis] + (float)tick * step[axis] + offset)) == tile)
+		tick++;
+	return tick;
+}
+
+/*
+	finds the first tick at which the robot, moving along one axis, collides with a tile.
+	only the leading edge of the robot can enter new tiles, so we walk the tiles it enters
+	and check them the same way collisionCheck does
+	returns the tick, or limit + 1 if the robot doesn't collide until limit
+*/
+long long Robot::ticksToCollision(glm::vec2 start, glm::vec2 step, long long limit) {
+	int axis = step.x != 0 ? 0 : 1;
+	float leadingOffset = step[axis] > 0 ? size : -size;
+	int other = 1 - axis;
+	// tiles covered by the robot on the other axis, they don't change
+	int sideTiles[2] = { TileGrid::toTile((int)(start[other] - size)), TileGrid::toTile((int)(start[other] + size)) };
+	long long tick = 0;
+	while (tick <= limit) {
+		tick = ticksToTileChange(start, step, tick, axis, leadingOffset, limit);
+		if (tick > limit)
+			break;
+		int leadingTile = TileGrid::toTile((int)(start[axis] + (float)tick * step[axis] + leadingOffset));
+		for (unsigned int i = 0; i < 2; i++) {
+			int col = axis == 0 ? leadingTile : sideTiles[i];
+			int row = axis == 0 ? sideTiles[i] : leadingTile;
+			if (tileMap->validMapPosition(col, row)
+				&& tileMap->isSolid(row, col)) {
+				return tick;
+			}
+		}
+	}
+	return limit + 1;
+}
+
+/*
+	Segment level integration for straight line motion.
+	While the robot is MOVING, MOVING_DOWN or GOING_BACK along one axis, the only thing a tick does
+	is move the robot, and when it enters another tile, spend time and battery and mow that tile.
+	Instead of running those ticks one by one, we compute analytically the tick at which the robot
+	will collide (or the state machine will react), and jump from one tile crossing to the next until then,
+	doing the same bookkeeping move() and Update2 would. The reacting tick is left to the regular Update/Update2 call.
+	It also skips the charging ticks left by chargeToFull, in both integration modes, and the ticks spent
+	holding for a detour (see planDetour).
+	Diagonal motion (Update's bouncing) is left to the regular ticks.
+	NOTE: positions are computed as start + ticks * step instead of being added tick by tick, so they
+	can differ from IntegrationMode::TICK in the last bits of the float (not with KinematicsMode::FIXED,
+	see fixedStep).
+	parameters:
+		seconds		- delta time of one tick
+		maxTicks	- maximum number of ticks that can be skipped
+	returns the number of ticks skipped, in IntegrationMode::TICK only charging ticks
+*/
+long long Robot::skipIdleTicks(float seconds, long long maxTicks) {
+	if (maxTicks <= 0)
+		return 0;
+	// charging ticks already accounted for by chargeToFull
+	if (pendingIdleTicks > 0) {
+		long long skippedTicks = pendingIdleTicks < maxTicks ? pendingIdleTicks : maxTicks;
+		pendingIdleTicks -= skippedTicks;
+		return skippedTicks;
+	}
+	if (integrationMode != IntegrationMode::SEGMENT)
+		return 0;
+	// holding for a detour, the robot reacts on the tick the delay runs out
+	if (state == RobotState::PLANNING && planningDelay > 0) {
+		long long ticksLeft = planningDelay - planningTicks - 1;
+		long long skippedTicks = ticksLeft < maxTicks ? ticksLeft : maxTicks;
+		if (skippedTicks <= 0)
+			return 0;
+		planningTicks += (int)skippedTicks;
+		return skippedTicks;
+	}
+	if (state != RobotState::MOVING && state != RobotState::MOVING_DOWN && state != RobotState::GOING_BACK)
+		return 0;
+	// swept steps already cover any distance in a tick, and aren't tick exact
+	if (collisionMode == CollisionMode::SWEPT)
+		return 0;
+	glm::vec2 step = kinematicsMode == KinematicsMode::FIXED
+		? glm::vec2(fixedStep(seconds)) / (float)SUBPIXELS
+		: tickStep(velocity, seconds);
+	if ((step.x == 0) == (step.y == 0))								// not moving, or moving diagonally
+		return 0;
+	// the next move() would record a displacement if the tile position is stale (e.g. after revertPosition)
+	if (tileMap->toMapPosition(position) != tileMapPosition)
+		return 0;
+	// the next tick mows the tile the robot is on if it isn't yet (the start tile), skips only mow the tiles they enter
+	if (tileMap->validMapPosition(tileMapPosition) && tileMap->isMowableTile(tileMapPosition.y, tileMapPosition.x))
+		return 0;
+	// a colliding robot will react on the next tick
+	if (state == RobotState::MOVING && collisionCheck() != CollisionType::NONE)
+		return 0;
+	// so will one that should head to a charger, e.g. after moving down
+	if (state == RobotState::MOVING && needsCharger(tileMapPosition, battery))
+		return 0;
+	// going back reacts every tick while on column 1 (moving sideways) or on the saved row
+	if (state == RobotState::GOING_BACK
+		&& ((tileMapPosition.x == 1 && velocity.x != 0) || tileMapPosition.y == savedMapPosition.y))
+		return 0;
+
+	glm::vec2 start = position;
+	glm::ivec2 subpixelStart = subpixelPosition;
+	int axis = step.x != 0 ? 0 : 1;
+	long long horizon = maxTicks;									// last tick that can be skipped
+	if (state == RobotState::MOVING) {
+		horizon = ticksToCollision(start, step, maxTicks) - 1;
+	}
+	long long skippedTicks = 0;
+	while (skippedTicks < horizon && tileMap->getTilesToMow() > 0) {
+		long long crossingTick = ticksToTileChange(start, step, skippedTicks, axis, 0.f, horizon);
+		if (crossingTick > horizon) {
+			skippedTicks = horizon;
+			break;
+		}
+		glm::vec2 nextTileMapPosition = tileMap->toMapPosition(start + (float)crossingTick * step);
+		bool reacts = state == RobotState::MOVING_DOWN					// moving down stops on the next tile
+			|| (state == RobotState::MOVING									// heads to a charger from the next tile
+				&& needsCharger(nextTileMapPosition, battery - (SECONDS / DISCHARGE_THRESHOLD) * 100.f))
+			|| (state == RobotState::GOING_BACK
+				&& (nextTileMapPosition.x == 1 || nextTileMapPosition.y == savedMapPosition.y));
+		if (reacts) {
+			skippedTicks = crossingTick - 1;
+			break;
+		}
+		// apply the crossing tick, same as move() followed by the mowing at the end of Update2
+		placeOnLine(start, subpixelStart, step, crossingTick);
+		updateTileMapPosition();
+		mowCurrentTile();
+		skippedTicks = crossingTick;
+	}
+	placeOnLine(start, subpixelStart, step, skippedTicks);
+	prevTileMapPosition = tileMapPosition;
+	return skippedTicks;
 }
 
 void Robot::reset() {
-	this->position = glm::vec2(25, 25);
+	setPosition(glm::vec2(25, 25));
 	this->state = RobotState::STOP;
 }
 
@@ -350,15 +977,23 @@ void Robot::moveToDirection(Direction direction) {
 /// it goes around it by finding the path of the next mowable tile within the same row.
 /// if it collides with a perimeter, it goes down 1 level.
 /// when battery is out it bounces around until it hits a perimeter and goes to the charger
+/// (or heads straight to the nearest charger with ChargerReturn::DISTANCE_FIELD, see needsCharger)
 /// when going to back to the previous position, the robot goes to the corner and goes to the 
 /// previous row and starts mowing again in a zigzag pattern
+/// with a coverage route (see setCoverageRoute) the robot mows along the route instead
 /// </summary>
 void Robot::Update2(float seconds) {
 	CollisionType colType;
 	if (state == RobotState::MOVING) {
-		move(seconds);
-		if ((colType = collisionCheck()) != CollisionType::NONE) {	// if colliding
-			revertPosition(seconds);								// revert position so it wouldn't clip
+		colType = moveAndCollide(seconds);
+		if (needsCharger(tileMapPosition, battery) && findChargerPath()) {	// head straight to a charger
+			followNewPath();
+			if (!mapPositionSaved) {								// save position for going back
+				savedMapPosition = tileMapPosition;
+				mapPositionSaved = true;
+			}
+		}
+		else if (colType != CollisionType::NONE) {					// if colliding
 			if (battery > 0											// if battery > 0
 				&& colType == CollisionType::PERIMETER) {			// if collision is a perimeter
 				if (tileMapPosition.y + 1 <= tileMap->getHeight() - 2) { // if not at the bottom mowable row
@@ -378,17 +1013,14 @@ void Robot::Update2(float seconds) {
 					tileMapPosition.y + directionTable[(int)zigzagDir][1]
 				);
 				while (tileMap->validMapPosition(mowablePosition)			// while mowableposition is an obstacle
-					&& tileMap->getTile(mowablePosition.y, mowablePosition.x).tileCollisionType() == CollisionType::OBSTACLE) {
+					&& tileMap->collisionType(mowablePosition.y, mowablePosition.x) == CollisionType::OBSTACLE) {
 					mowablePosition = glm::vec2(
 						mowablePosition.x + directionTable[(int)zigzagDir][0],	// keep iterating through the row one by one
 						mowablePosition.y + directionTable[(int)zigzagDir][1]	// direction here is based on the current zigzag direction
 					);
 				}
 				// find the path for this next mowable tile
-				path = searchNextPath(mowablePosition);
-				// setup variables for following path
-				pathIndex = 0;
-				state = RobotState::FOLLOWING_PATH;
+				planDetour(mowablePosition);
 			}
 			else if (battery <= 0 
 				&& colType == CollisionType::OBSTACLE) // if no more battery 
@@ -411,19 +1043,18 @@ void Robot::Update2(float seconds) {
 		}
 	} 
 	else if (state == RobotState::LOOKUP_CHARGE_STN) {			// if state is looking for chargin station
-		if (tileMap->getTile(tileMapPosition.y, tileMapPosition.x).isChargingTile()) {		// if current position is a chargin tile
+		if (tileMap->isChargingTile(tileMapPosition.y, tileMapPosition.x)) {		// if current position is a chargin tile
 			velocity *= 0;																	// stop the robot
 			state = RobotState::CHARGING;													// set state as charging
-			position = glm::vec2(tileMapPosition.x * 16 + size, tileMapPosition.y * 16 + size);	// snap it to the center of the charging station
+			setPosition(glm::vec2(TileGrid::toPixel(tileMapPosition.x) + size, TileGrid::toPixel(tileMapPosition.y) + size));	// snap it to the center of the charging station
 		}
 		getDirectionAlongPerimeter(seconds);												// move along perimeter
 		move(seconds);																		// update position
 	} 
 	else if (state == RobotState::CHARGING) {												// if state is charging
 		if (battery < 100) {
-			battery += 1;
-			timePassed += 1.f/100.f * SECONDS;
-		}																// increment battery untill 100
+			chargeToFull(false);										// charge in one step and skip the charging ticks
+		}
 		else {
 			battery = 100;
 			resumePreviousPosition();									// go back to previous position
@@ -447,38 +1078,265 @@ void Robot::Update2(float seconds) {
 		bool robotDisplacement = tileMapPosition.x - prevTileMapPosition.x != 0
 			|| tileMapPosition.y - prevTileMapPosition.y != 0;
 		if (robotDisplacement) {
-			position = glm::vec2(tileMapPosition.x * 16 + size, tileMapPosition.y * 16 + size);
+			setPosition(glm::vec2(TileGrid::toPixel(tileMapPosition.x) + size, TileGrid::toPixel(tileMapPosition.y) + size));
 			velocity *= 0;
 			moveOpposite();
 		}
 	}
 	else if (state == RobotState::FOLLOWING_PATH) {						// if robot state is following a path
-		if (pathIndex == path.size()) {									// if at the last position of a path
-			position = glm::vec2(tileMapPosition.x * 16 + size,			// snap to the cell
-				tileMapPosition.y * 16 + size);
-			state = RobotState::MOVING;
-			moveToDirection((Direction)zigzagDir);
+		followPath(seconds);
+	}
+	else if (state == RobotState::PLANNING) {							// waiting for the detour around an obstacle
+		waitForDetour();
+	}
+	else if (state == RobotState::FOLLOWING_ROUTE) {					// mowing along the coverage route
+		followRoute(seconds);
+	}
+	// set current position of robot to mowed, if it's mowable
+	mowCurrentTile();
+}
+
+/*
+	steps the robot along its current path, one tile at a time, the path ends either back to mowing
+	in the zigzag direction (a detour around an obstacle) or on a charging station (see findChargerPath)
+*/
+void Robot::followPath(float seconds) {
+	if (pathVersion != tileMap->getVersion() && pathIndex < (int)path.size())
+		repairPath();												// tiles were edited, the path may be blocked or longer than needed
+	if (pathIndex == (int)path.size()) {							// if at the last position of a path
+		setPosition(glm::vec2(TileGrid::toPixel(tileMapPosition.x) + size,	// snap to the cell
+			TileGrid::toPixel(tileMapPosition.y) + size));
+		if (pathToCharger) {										// at the charger, start charging
+			velocity *= 0;
+			pathToCharger = false;
+			state = RobotState::CHARGING;
+		}
+		else if (!route.empty()) {									// back on the coverage route
+			velocity *= 0;
+			state = RobotState::FOLLOWING_ROUTE;
 		}
 		else {
-			glm::vec2 nextPos = path[pathIndex];						// store next pos in variable
-			glm::vec2 pathVector = nextPos - tileMapPosition;			// get vector from two points, subtraction
-			if (pathVector.x == 0 && pathVector.y == 0) {				// if subtraction resulted into 0,
-				position = glm::vec2(tileMapPosition.x * 16 + size, tileMapPosition.y * 16 + size);
-				pathIndex++;
-				velocity *= 0;
-			}
-			else {
-				velocity = speed * pathVector;							// else set the direction to the vector
-			}
+			state = RobotState::MOVING;
+			moveToDirection((Direction)zigzagDir);
 		}
-		
-		move(seconds);
 	}
-	// set current position of robot to mowed, if it's mowable
-	if (tileMap->validMapPosition(tileMapPosition)
-		&& tileMap->getTile(tileMapPosition.y, tileMapPosition.x).isMowableTile()) {
-		tileMap->mowTile(tileMapPosition.y, tileMapPosition.x);
+	else {
+		steerTowards(path[pathIndex], pathIndex);
 	}
+
+	move(seconds);
+}
+
+/*
+	heads the robot to the next waypoint of a path or route, a tile away, once the robot is on it
+	it's snapped to the middle of the tile and the index moves on to the waypoint after it
+	parameters:
+		nextPos		- the waypoint
+		index		- index of the waypoint, incremented when it's reached
+*/
+void Robot::steerTowards(glm::vec2 nextPos, int& index) {
+	glm::vec2 pathVector = nextPos - tileMapPosition;				// get vector from two points, subtraction
+	if (pathVector.x == 0 && pathVector.y == 0) {					// if subtraction resulted into 0,
+		setPosition(glm::vec2(TileGrid::toPixel(tileMapPosition.x) + size, TileGrid::toPixel(tileMapPosition.y) + size));
+		index++;
+		velocity *= 0;
+	}
+	else {
+		velocity = speed * pathVector;								// else set the direction to the vector
+		if (pathVector.x != 0 && pathVector.y != 0)
+			velocity *= 0.70710678f;								// diagonal step, same speed as a straight one
+	}
+}
+
+/*
+	mows along the coverage route one tile at a time. At the end of a leg of the route, or when the battery
+	runs out, the robot goes down the distance field to the nearest charger and, once charged, finds its
+	way back to the tile of the route it was heading to. Tiles of the route an obstacle was put on since
+	are skipped and the robot goes around to the next one. The robot stops at the end of the route.
+*/
+void Robot::followRoute(float seconds) {
+	while (routeIndex < (int)route.size() && tileMap->isSolid(route[routeIndex].y, route[routeIndex].x))
+		routeIndex++;
+	bool legDone = false;
+	while (nextLeg < (int)legEnds.size() && routeIndex > legEnds[nextLeg]) {
+		nextLeg++;
+		legDone = true;
+	}
+	if ((legDone || battery <= 0) && routeIndex < (int)route.size() && findChargerPath()) {
+		followNewPath();
+		return;
+	}
+	if (routeIndex == (int)route.size()) {							// covered, whatever is left can't be reached
+		velocity *= 0;
+		state = RobotState::STOP;
+		return;
+	}
+	glm::vec2 offset = route[routeIndex] - tileMapPosition;
+	if (fabs(offset.x) + fabs(offset.y) > 1) {						// off the route, back from charging or around an obstacle
+		velocity *= 0;
+		if (pathFinder.findPath(tileMapPosition, route[routeIndex], path))
+			followNewPath();
+		else
+			routeIndex++;
+		return;
+	}
+	steerTowards(route[routeIndex], routeIndex);
+	move(seconds);
+}
+
+/*
+	makes the robot mow along a route (see CoveragePlanner) instead of zigzagging, call after start
+	parameters:
+		route	- the tiles to go through, one step apart, starting with the robot's tile
+		legEnds	- route indices to go charging from, in order, see CoveragePlanner::splitLegs
+*/
+void Robot::setCoverageRoute(const std::vector<glm::vec2>& route, const std::vector<int>& legEnds) {
+	this->route = route;
+	this->legEnds = legEnds;
+	routeIndex = 0;
+	nextLeg = 0;
+	if (!this->route.empty()) {
+		velocity *= 0;
+		state = RobotState::FOLLOWING_ROUTE;
+	}
+}
+
+/*
+	starts following the path just found
+*/
+void Robot::followNewPath() {
+	velocity *= 0;
+	pathIndex = 0;
+	pathVersion = tileMap->getVersion();
+	state = RobotState::FOLLOWING_PATH;
+}
+
+/*
+	asks for the path to the next mowable tile past an obstacle and holds in PLANNING until it's taken,
+	see setPlannerPool. With a pool the workers search a copy of the map as it is now, a copy is only
+	taken again once the map's version changed. Without a pool the path is searched right away.
+	parameters:
+		goal	- the tile to get to
+*/
+void Robot::planDetour(glm::vec2 goal) {
+	velocity *= 0;
+	pathVersion = tileMap->getVersion();
+	if (plannerPool) {
+		if (!planningMap || planningMap->getVersion() != pathVersion)
+			planningMap = std::make_shared<const TileMap>(*tileMap);
+		PlanRequest request;
+		request.map = planningMap;
+		request.planner = pathFinder.getPlanner();
+		request.allowDiagonal = pathFinder.getAllowDiagonal();
+		request.cache = pathFinder.getCache();
+		request.start = tileMapPosition;
+		request.goal = goal;
+		request.preferredDirection = zigzagDir;
+		plannedDetour = plannerPool->submit(request);
+	}
+	else {
+		detourFound = pathFinder.findPath(tileMapPosition, goal, path, zigzagDir);
+	}
+	planningTicks = 0;
+	state = RobotState::PLANNING;
+	if (planningDelay == 0 || (planningDelay < 0 && !plannerPool))
+		takeDetour();
+}
+
+/*
+	one tick of PLANNING, takes the detour once the robot waited planningDelay ticks,
+	or when the pool is done with it if the delay is -1
+*/
+void Robot::waitForDetour() {
+	planningTicks++;
+	bool ready;
+	if (planningDelay >= 0 || !plannerPool)
+		ready = planningTicks >= planningDelay;
+	else
+		ready = plannedDetour.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	if (ready)
+		takeDetour();
+}
+
+/*
+	follows the detour asked for by planDetour (waiting for the pool if it isn't done yet),
+	if there's none the obstacle is treated like a perimeter. The path is repaired by followPath
+	if the map was edited while the robot was waiting.
+*/
+void Robot::takeDetour() {
+	if (plannerPool) {
+		PlanResult result = plannedDetour.get();
+		detourFound = result.found;
+		path.swap(result.path);
+		pathFinder.countSearch(result.expandedTiles, result.cacheHit);
+	}
+	if (detourFound) {
+		unsigned long long plannedVersion = pathVersion;
+		followNewPath();
+		pathVersion = plannedVersion;
+	}
+	else if (tileMapPosition.y + 1 <= tileMap->getHeight() - 2	// no way around the obstacle, treat it like a perimeter
+		&& !tileMap->isSolid(tileMapPosition.y + 1, tileMapPosition.x)) {
+		moveToDirection((Direction)DOWN);
+		state = RobotState::MOVING_DOWN;
+	}
+	else {														// can't go around or below, done mowing
+		state = RobotState::STOP;
+	}
+}
+
+/*
+	finds the current path again after tiles turned solid or open while the robot follows it,
+	from the tile the robot is on to the same goal, with PathPlanner::DSTAR only the costs around
+	the edited tiles are redone. If the goal can't be reached anymore the path is dropped
+	and the robot goes back to mowing from where it is.
+*/
+void Robot::repairPath() {
+	pathVersion = tileMap->getVersion();
+	bool found;
+	if (pathToCharger)
+		found = findChargerPath();
+	else
+		found = pathFinder.findPath(tileMapPosition, path.back(), path, zigzagDir);
+	if (!found) {
+		path.clear();
+		pathToCharger = false;
+	}
+	pathIndex = 0;
+}
+
+/*
+	returns true when a moving robot should head to a charger, with ChargerReturn::DISTANCE_FIELD as soon as
+	the battery left only just covers the tiles down the distance field to the nearest charger (plus one, the
+	tile before could be one closer), so it gets there before running out, or once the battery is out.
+	With ChargerReturn::PERIMETER it's always false, the robot looks for the perimeter at its next collision
+	parameters:
+		mapPosition	- the tile the robot is on
+		batteryLeft	- the battery it has there
+*/
+bool Robot::needsCharger(glm::vec2 mapPosition, float batteryLeft) {
+	if (chargerReturn != ChargerReturn::DISTANCE_FIELD && route.empty())
+		return false;
+	if (batteryLeft <= 0)
+		return true;
+	if (!tileMap->validMapPosition(mapPosition))
+		return false;
+	int distance = tileMap->getChargerDistances().getDistance((int)mapPosition.y, (int)mapPosition.x);
+	return distance >= 0 && batteryLeft <= (distance + 2) * (SECONDS / DISCHARGE_THRESHOLD) * 100.f;
+}
+
+/*
+	sets the path to the nearest charging station when the robot returns with ChargerReturn::DISTANCE_FIELD
+	(always on a coverage route), the path comes down the map's distance field so there's no search
+	returns false if the robot returns along the perimeter instead, or can't reach a charger from here
+*/
+bool Robot::findChargerPath() {
+	if (chargerReturn != ChargerReturn::DISTANCE_FIELD && route.empty())
+		return false;
+	if (!tileMap->getChargerDistances().descend((int)tileMapPosition.y, (int)tileMapPosition.x, path))
+		return false;
+	pathToCharger = true;
+	return true;
 }
 
 /**
@@ -492,59 +1350,25 @@ void Robot::moveOpposite() {
 };
 
 /**
-*	set state to going back and move to the left
+*	set state to going back and move to the left, a robot on a coverage route heads back to it instead.
+*	With ResumeMode::SHORTEST_PATH the robot follows the shortest path to the saved position and goes on
+*	in its zigzag direction from there (see followPath), going back the long way only if there's no path.
 */
 void Robot::resumePreviousPosition() {
+	if (!route.empty()) {											// followRoute finds the way back
+		velocity *= 0;
+		state = RobotState::FOLLOWING_ROUTE;
+		return;
+	}
+	if (resumeMode == ResumeMode::SHORTEST_PATH && mapPositionSaved
+		&& pathFinder.findPath(tileMapPosition, savedMapPosition, path, zigzagDir)) {
+		prevPerimeterDirection = NONE;
+		currPerimeterDirection = NONE;
+		mapPositionSaved = false;
+		followNewPath();
+		return;
+	}
 	start();
 	state = RobotState::GOING_BACK;
 	moveToDirection((Direction) LEFT);
 }
-
-/*
-	Finds the path for the passed position, uses the Breadth-First search algorithm.
-	Reference used: 
-		Breadth-First Search. (n.d.). In Wikipedia. 
-			Retrieved November 20, 2023, from https://en.wikipedia.org/wiki/Breadth-first_search
-*/
-std::vector<glm::vec2> Robot::searchNextPath(glm::vec2 goalPosition) {
-	std::queue<std::vector<glm::vec2>> q;									// queue of paths to keep track which optimal path to take
-	std::vector<std::vector<boolean>> visitedMap(tileMap->getHeight(),		// a 2d vector of visited map
-		std::vector<boolean>(tileMap->getWidth()));
-	std::vector<glm::vec2> currPath;										// declare current path
-	glm::vec2 lastPos;														// declare lastPosition of the path
-	int nextX = -1;															// initialize nextX
-	int nextY = -1;															// initalize nextY
-	std::vector<glm::vec2> initialPath = { tileMapPosition };				// set initial path, the current tile position
-	q.push(initialPath);													// push initial path to the queue
-	Direction possibleDirections[4] = {
-		Direction::UP,
-		Direction::DOWN,
-		Direction::LEFT,
-		Direction::RIGHT,
-	};
-	while (!q.empty()) {													// while the queue is not empty
-		currPath = q.front();												// dequeue an path element from the queue
-		q.pop();															
-		lastPos = currPath.back();											// get the last position of the path 
-		if (lastPos == goalPosition) {										// check if the last position  is the goal position
-			return currPath;												// return the path
-		}
-
-		for (unsigned int i = 0; i < 4; i++) {										// for each directions in the direction table
-			nextX = lastPos.x + directionTable[possibleDirections[i]][0];	// get the x and y position for the direction
-			nextY = lastPos.y + directionTable[possibleDirections[i]][1];	//
-			glm::vec2 nextPos = glm::vec2(nextX, nextY);					// make it a coordinate
-
-			if (tileMap->validMapPosition(nextPos)							// if the coordinate is valid
-				&& !visitedMap[nextPos.y][nextPos.x]						// and not yet visited
-				&& tileMap->getTile(nextPos.y, nextPos.x).tileCollisionType() == CollisionType::NONE) { // and not a collision type
-				visitedMap[nextY][nextX] = true;							// mark it as visited
-				std::vector<glm::vec2> newPath = currPath;					// make it a new path based on the new coordinate and its previous path
-				newPath.push_back(nextPos);	
-				q.push(newPath);											// enqueue the path 					
-			}
-		}
-		
-	}
-	
-}
\ No newline at end of file
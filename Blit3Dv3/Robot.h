@@ -1,9 +1,25 @@
 #pragma once
 #include "Direction.h"
-#include "Blit3D.h";
 #include "CollisionType.h"
+#include "PathFinder.h"
+#include "PlannerPool.h"
+#include "TileGrid.h"
+#include <future>
+#include <glm/glm.hpp>
+#include <memory>
 #include <random>
-#include <queue>
+#include <string>
+#include <vector>
+
+// a band of the charge curve, from batteryLevel up the robot charges rate % per tick
+struct ChargeCurveBand {
+	float batteryLevel;
+	float rate;
+};
+
+class Sprite;
+class TileMap;
+
 enum class RobotState {
 	MOVING,								// when robot is moving 
 	MOVING_DOWN,						// state when robot is transitioning to another row
@@ -12,6 +28,47 @@ enum class RobotState {
 	CHARGING,							// robot is charging
 	LOOKUP_CHARGE_STN,					// robot is looking for the chargin station
 	STOP,								// robot has stopped (initial state)
+	PLANNING,							// robot holds still until the detour around an obstacle is found, see setPlannerPool
+	FOLLOWING_ROUTE,					// robot mows along a precomputed coverage route, see setCoverageRoute
+};
+
+enum class IntegrationMode {
+	TICK,								// advance the robot one time slice at a time
+	SEGMENT,							// jump over the ticks of straight line motion where nothing but the position changes
+};
+
+// how a moving robot finds out it ran into something
+enum class CollisionMode {
+	SAMPLED,							// move, check the corners of the robot where it ended up and back off if colliding
+	SWEPT,								// sweep the robot along the move and stop where it touches the tile, see TileMap::sweepBox,
+										// look-ahead is a raycast
+};
+
+// how the robot's position is advanced every tick
+enum class KinematicsMode {
+	FLOAT,								// position += velocity * seconds, rounded by the float however it comes out
+	FIXED,								// the position and the step of a tick are whole 256ths of a pixel in ints (see Robot::fixedStep),
+										// and bounce headings are whole degrees off a sine table, so a run comes out the same
+										// on any build (with CollisionMode::SAMPLED)
+};
+
+// how the robot picks its new heading when it bounces off something
+enum class BounceMode {
+	RANDOM,								// 120 +- 15 degrees left or right, the other side if the first one is blocked
+	MOST_UNMOWED,						// of a fan of headings, the one going over the most unmowed tiles (then the longest run),
+										// a random bounce if there are none
+};
+
+// how a robot out of battery gets to a charging station
+enum class ChargerReturn {
+	PERIMETER,							// bounce until it hits the perimeter, then follow the perimeter to a charger
+	DISTANCE_FIELD,						// head straight to the nearest charger once the battery only just gets there, see TileMap::getChargerDistances
+};
+
+// how a charged robot gets back to where it stopped mowing
+enum class ResumeMode {
+	GOING_BACK,							// left to column 1, down to the saved row and mow it again from the left
+	SHORTEST_PATH,						// shortest path to the saved position, then on in the zigzag direction it had
 };
 
 class Robot
@@ -22,48 +79,109 @@ private:
 	static float HOURS;					// hours in seconds
 	static float MINUTES;				// minutes in seconds
 	static float DISCHARGE_THRESHOLD;	// 2 hours, in seconds
+	static const int SUBPIXELS = 256;	// steps of a pixel with KinematicsMode::FIXED
 	std::mt19937 rng;					// rng for choosing the angle
 	// ===== DATA MEMBERS ====== /
-	Sprite* sprite;									// sprite of the robot
+	TileMap* tileMap;								// the map the robot is mowing
+	Sprite* sprite;									// sprite of the robot, NULL when running headless
 	RobotState state = RobotState::STOP;			// state of the robot, initial value set to stop
-	glm::vec2 position;								// actual position of the robot in the world map in pixcels
+	glm::vec2 position;								// actual position of the robot in the world map in pixcels, with KinematicsMode::FIXED
+													// worked out from subpixelPosition for drawing and the sweeps and rays of TileMap
+	glm::ivec2 subpixelPosition = glm::ivec2(0, 0);	// KinematicsMode::FIXED, the position in 256ths of a pixel
+	glm::ivec2 tile;								// tile the robot is on, tileMapPosition is worked out from it
 	glm::vec2 tileMapPosition;						// local position of the robot, relative to the visible view of the map
 	glm::vec2 prevTileMapPosition;					// previous tile position
 	glm::vec2 screenPosition;						// screen position of the robot
 	glm::vec2 velocity = glm::vec2(0, 0);			// velocity of the robot
+	glm::ivec2 subpixelVelocity = glm::ivec2(0, 0);	// KinematicsMode::FIXED, velocity in 256ths of a pixel per tick, see fixedStep
+	glm::vec2 roundedVelocity = glm::vec2(0, 0);	// velocity and tick length subpixelVelocity was rounded from
+	float roundedSeconds = 0;
 	glm::vec2 savedMapPosition;						// map position to resume after charging
 	std::vector<glm::vec2> path;					// current path the robot is following
+	std::vector<glm::vec2> route;					// coverage route mowed in FOLLOWING_ROUTE, empty when mowing zigzag
+	std::vector<int> legEnds;						// route indices the robot goes charging from, see CoveragePlanner::splitLegs
+	int nextLeg = 0;								// first of legEnds not reached yet
+	PathFinder pathFinder;							// finds paths around obstacles, reuses its buffers
 	float speed = 500.f;							// speed of the robot
-	float size = 5.f;								// the half size of the robot (16 is the actual size)
+	float size = TileGrid::ROBOT_HALF_SIZE;			// the half size of the robot, from its center to its sides
 	float battery = 100.f;							// current battery charge of the robot, initial value set to 100.f
 	float batteryChargeRate = 50.f;					// charge rate
 	float timePassed = 0;							// elapsed time, in HOURS
 	int pathIndex = 0;								// index of the position in the current path
+	int routeIndex = 0;								// index of the next tile of the coverage route
+	unsigned long long pathVersion = 0;				// map version (TileMap::getVersion) the path was found on
+	std::shared_ptr<PlannerPool> plannerPool;		// searches detours on worker threads, null to search in Update2
+	std::shared_ptr<const TileMap> planningMap;		// copy of the map the pool searches, taken at the last version a detour was asked on
+	std::future<PlanResult> plannedDetour;			// detour being searched by the pool
+	bool detourFound = false;						// result of the detour searched without a pool
+	int planningDelay = 0;							// ticks spent in PLANNING, -1 for as long as the pool takes
+	int planningTicks = 0;							// ticks spent in PLANNING so far
 	int rechargeCount = 0;
 	bool mapPositionSaved = false;
+	bool pathToCharger = false;						// the current path ends at a charging station
 	Direction dir;									// direction of the robot
 	Direction zigzagDir = NONE;
 	Direction prevPerimeterDirection = NONE;		// current perimeter direction, used for following perimeter path
 	Direction currPerimeterDirection = NONE;		// previous perimeter direction, used for following the perimeter path
+	IntegrationMode integrationMode = IntegrationMode::TICK;	// how skipIdleTicks advances the robot
+	CollisionMode collisionMode = CollisionMode::SAMPLED;		// how the robot collides in MOVING
+	KinematicsMode kinematicsMode = KinematicsMode::FLOAT;		// how the position is stepped
+	BounceMode bounceMode = BounceMode::RANDOM;				// how the robot picks a heading when it bounces
+	int bounceCandidates = 8;						// headings weighed per bounce, see bounceToBestHeading
+	ChargerReturn chargerReturn = ChargerReturn::PERIMETER;		// how the robot gets to a charger when out of battery
+	ResumeMode resumeMode = ResumeMode::GOING_BACK;				// how the robot gets back to mowing after charging
+	long long pendingIdleTicks = 0;					// ticks already simulated in one step, see chargeToFull
+	std::vector<ChargeCurveBand> chargeCurve;		// charge rate per battery band, empty means 1% per tick
 	// ========= FUNCTIONS ================================== //
 	// refer to implementation file for mroe details
 	CollisionType collisionCheck();
 	void bounce(float seconds);
+	bool bounceToBestHeading();
 	void revertPosition(float seconds);
+	glm::vec2 tickStep(glm::vec2 velocity, float seconds);
+	glm::ivec2 fixedStep(float seconds);
+	glm::vec2 headingVelocity(float degrees);
+	static glm::vec2 toSubpixelGrid(glm::vec2 vector);
+	static glm::ivec2 toSubpixels(glm::vec2 pixels);
+	static int subpixelTile(int subpixels);
+	void setPosition(glm::vec2 pixels);
+	void placeOnLine(glm::vec2 start, glm::ivec2 subpixelStart, glm::vec2 step, long long ticks);
+	static int headingDegrees(glm::vec2 vector);
+	static glm::vec2 headingVector(int degrees);
+	long long ticksToTileChange(glm::vec2 start, glm::vec2 step, long long fromTick, int axis, float offset, long long limit);
+	long long ticksToCollision(glm::vec2 start, glm::vec2 step, long long limit);
 	bool lookAheadCollision(int ticks, glm::vec2 velocity, float seconds);
 	void reset();
 	void move(float seconds);
+	CollisionType moveAndCollide(float seconds);
+	CollisionType sweepMove(float seconds);
+	void moveTo(glm::vec2 target);
+	void updateTileMapPosition();
+	void mowCurrentTile();
+	float chargeRateAt(float battery);
+	void chargeToFull(bool inclusive);
+	int randomInt(int min, int max);
 	void getDirectionAlongPerimeter(float seconds);
+	bool needsCharger(glm::vec2 mapPosition, float batteryLeft);
+	bool findChargerPath();
+	void followPath(float seconds);
+	void followRoute(float seconds);
+	void steerTowards(glm::vec2 nextPos, int& index);
+	void followNewPath();
+	void repairPath();
+	void planDetour(glm::vec2 goal);
+	void waitForDetour();
+	void takeDetour();
 	void getValidMoveAlongDirections(glm::vec2 tileMapPosition, bool result[]);
 	void resumePreviousPosition();
 	Direction getOppositeDirection(Direction direction);
-	std::vector<glm::vec2> searchNextPath(glm::vec2 goalPosition);
 public:
 	static float directionTable[][2];
 	// ========= FUNCTIONS ================================== //
 	// refer to the implementation file for more details.
-	Robot(int posX, int posY, Sprite* sprite,
+	Robot(TileMap* tileMap, int posX, int posY, Sprite* sprite = NULL,
 		Direction initialDirection = DOWN);
+	void centerOnScreen(float screenHeight);
 	void Draw();									
 	void Update(float seconds);	
 	void Update2(float seconds);
@@ -71,6 +189,17 @@ public:
 	void moveToDirection(Direction direction);
 	void moveBelow();
 	void moveOpposite();
+	long long skipIdleTicks(float seconds, long long maxTicks);
+	void setCoverageRoute(const std::vector<glm::vec2>& route, const std::vector<int>& legEnds = std::vector<int>());
+	void setSeed(unsigned long long seed, unsigned long long stream = 0);
+	static bool LoadChargeCurve(std::string filename, std::vector<ChargeCurveBand>& chargeCurve);
+	static const char* bounceModeName(BounceMode mode);
+	static bool parseBounceMode(std::string name, BounceMode& mode);
+
+	// tiles the robot moves on a full battery, it spends battery on every tile it enters
+	static int getTilesPerCharge() {
+		return (int)(DISCHARGE_THRESHOLD / SECONDS);
+	}
 	// getters and setters 
 	glm::vec2 getPosition() {
 		return position;
@@ -99,5 +228,103 @@ public:
 	int getRechargeCount() {
 		return rechargeCount;
 	}
+
+	IntegrationMode getIntegrationMode() {
+		return integrationMode;
+	}
+
+	void setIntegrationMode(IntegrationMode mode) {
+		integrationMode = mode;
+	}
+
+	CollisionMode getCollisionMode() {
+		return collisionMode;
+	}
+
+	void setCollisionMode(CollisionMode mode) {
+		collisionMode = mode;
+	}
+
+	KinematicsMode getKinematicsMode() {
+		return kinematicsMode;
+	}
+
+	void setKinematicsMode(KinematicsMode mode) {
+		kinematicsMode = mode;
+		setPosition(position);
+	}
+
+	BounceMode getBounceMode() {
+		return bounceMode;
+	}
+
+	// candidates is the number of headings weighed per bounce, unused with BounceMode::RANDOM
+	void setBounceMode(BounceMode mode, int candidates = 8) {
+		bounceMode = mode;
+		bounceCandidates = candidates > 0 ? candidates : 1;
+	}
+
+	int getBounceCandidates() {
+		return bounceCandidates;
+	}
+
+	ChargerReturn getChargerReturn() {
+		return chargerReturn;
+	}
+
+	void setChargerReturn(ChargerReturn chargerReturn) {
+		this->chargerReturn = chargerReturn;
+	}
+
+	ResumeMode getResumeMode() {
+		return resumeMode;
+	}
+
+	void setResumeMode(ResumeMode resumeMode) {
+		this->resumeMode = resumeMode;
+	}
+
+	void setChargeCurve(const std::vector<ChargeCurveBand>& curve) {
+		chargeCurve = curve;
+	}
+
+	// how the robot finds its way around obstacles, see PathFinder
+	void setPathPlanner(PathPlanner planner, bool allowDiagonal = false) {
+		pathFinder.setPlanner(planner);
+		pathFinder.setAllowDiagonal(allowDiagonal);
+	}
+
+	// paths found before, shared with the other robots of a batch, null for none
+	void setPathCache(std::shared_ptr<PathCache> cache) {
+		pathFinder.setCache(cache);
+	}
+
+	// searches detours on the pool's workers (null searches them in Update2), the robot holds in PLANNING
+	// for delay ticks, or with -1 until the pool is done (not reproducible), see planDetour
+	void setPlannerPool(std::shared_ptr<PlannerPool> pool, int delay = 0) {
+		plannerPool = pool;
+		planningDelay = delay;
+	}
+
+	int getPlanningDelay() {
+		return planningDelay;
+	}
+
+	const std::vector<glm::vec2>& getCoverageRoute() {
+		return route;
+	}
+
+	// legs of the coverage route the robot is done with
+	int getLegsDone() {
+		return nextLeg;
+	}
+
+	const PathFinder& getPathFinder() {
+		return pathFinder;
+	}
+
+	glm::vec2 getVelocity() {
+		return velocity;
+	}
 };
 
@@ -0,0 +1,189 @@
+#include "Simulation.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+/*
+	Constructor, copies the map so several simulations can share one loaded map
+	and starts the robot with the given settings
+*/
+Simulation::Simulation(const TileMap& map, const SimulationSettings& settings)
+	: tileMap(map),
+	robot(&tileMap, settings.startX, settings.startY),
+	settings(settings)
+{
+	if (settings.seeded)
+		robot.setSeed(settings.seed, settings.stream);
+	robot.setIntegrationMode(settings.integrationMode);
+	robot.setCollisionMode(settings.collisionMode);
+	robot.setKinematicsMode(settings.kinematicsMode);
+	robot.setBounceMode(settings.bounceMode, settings.bounceCandidates);
+	robot.setChargeCurve(settings.chargeCurve);
+	robot.setPathPlanner(settings.pathPlanner, settings.allowDiagonal);
+	robot.setChargerReturn(settings.chargerReturn);
+	robot.setResumeMode(settings.resumeMode);
+	robot.setPathCache(settings.pathCache);
+	robot.setPlannerPool(settings.plannerPool, settings.planningDelay);
+	robot.start();
+	if (settings.strategy == UpdateStrategy::ROUTE) {
+		CoveragePlanner coveragePlanner(&tileMap);
+		std::vector<glm::vec2> route;
+		std::vector<int> legEnds;
+		coveragePlanner.plan(glm::vec2(settings.startX, settings.startY), route);
+		if (settings.routeLegReserve >= 0) {
+			int tilesPerCharge = (int)(Robot::getTilesPerCharge() * (100.f - settings.routeLegReserve) / 100.f);
+			coveragePlanner.splitLegs(route, tilesPerCharge, legEnds);
+		}
+		robot.setCoverageRoute(route, legEnds);
+		routeCells = coveragePlanner.getCoveredCells();
+		routeLegs = (int)legEnds.size() + 1;
+		legStart = tileMap.getCoverage().snapshot();
+	}
+	lastTilesMowed = tileMap.getTilesMowed();
+}
+
+/*
+	advances the simulation by one fixed time step
+*/
+void Simulation::step()
+{
+	applyObstacleEvents();
+	if (settings.strategy == UpdateStrategy::BOUNCE)
+		robot.Update(settings.timeSlice);
+	else
+		robot.Update2(settings.timeSlice);
+	ticks++;
+	trajectoryHash.record(robot);
+
+	// a leg of the route is done, count what it mowed and start the next one from here
+	while (robot.getLegsDone() > (int)legTilesMowed.size()) {
+		legTilesMowed.push_back(tileMap.getCoverage().countMowedSince(legStart));
+		legStart = tileMap.getCoverage().snapshot();
+	}
+
+	// stuck detection, the robot should mow a tile every now and then
+	if (tileMap.getTilesMowed() != lastTilesMowed) {
+		lastTilesMowed = tileMap.getTilesMowed();
+		lastMowTick = ticks;
+	}
+	else if (settings.stuckTicks > 0 && ticks - lastMowTick >= settings.stuckTicks) {
+		stuck = true;
+	}
+}
+
+/*
+	puts on or takes off the obstacles of the events due by the current tick,
+	an obstacle isn't put on the tile the robot is on, that event (and the ones after it) wait until the robot leaves
+*/
+void Simulation::applyObstacleEvents()
+{
+	const std::vector<ObstacleEvent>& events = settings.obstacleEvents;
+	while (nextObstacleEvent < events.size() && events[nextObstacleEvent].tick <= ticks) {
+		const ObstacleEvent& event = events[nextObstacleEvent];
+		if (!tileMap.validMapPosition(event.col, event.row)) {
+			nextObstacleEvent++;
+			continue;
+		}
+		glm::vec2 robotTile = robot.getTileMapPosition();
+		if (event.foregroundTileNum != -1 && (int)robotTile.x == event.col && (int)robotTile.y == event.row)
+			break;
+		if (event.foregroundTileNum == -1)
+			tileMap.removeObstacle(event.row, event.col);
+		else
+			tileMap.placeObstacle(event.row, event.col, event.foregroundTileNum);
+		nextObstacleEvent++;
+	}
+}
+
+/*
+	loads obstacle events, one per line: tick row col foreground (-1 to take the obstacle away)
+	the events are sorted by tick, events of the same tick keep their order
+	returns true if the file was loaded
+*/
+bool Simulation::LoadObstacleEvents(std::string filename, std::vector<ObstacleEvent>& events)
+{
+	std::ifstream eventFile;
+	eventFile.open(filename);
+	if (!eventFile.is_open()) {
+		std::cout << "Can't open obstacle events file!" << std::endl;
+		return false;
+	}
+	std::vector<ObstacleEvent> loaded;
+	ObstacleEvent event;
+	while (eventFile >> event.tick >> event.row >> event.col >> event.foregroundTileNum) {
+		loaded.push_back(event);
+	}
+	std::stable_sort(loaded.begin(), loaded.end(),
+		[](const ObstacleEvent& a, const ObstacleEvent& b) { return a.tick < b.tick; });
+	events = loaded;
+	return true;
+}
+
+/*
+	returns true when there is nothing left to simulate,
+	either every tile is mowed, the robot has stopped by itself or it is stuck
+*/
+bool Simulation::isFinished()
+{
+	return tileMap.getTilesToMow() == 0 || robot.getState() == RobotState::STOP || stuck;
+}
+
+/*
+	steps the simulation until it finishes or maxTicks ticks have been simulated,
+	the robot jumps over its charging ticks, and in IntegrationMode::SEGMENT over idle ticks of straight line motion
+	returns the summary of the run
+*/
+SimulationResult Simulation::run(long long maxTicks)
+{
+	while (!isFinished() && ticks < maxTicks) {
+		long long skipLimit = maxTicks - ticks - 1;
+		if (nextObstacleEvent < settings.obstacleEvents.size())	// the map must not change in the middle of a skip
+			skipLimit = std::max(0LL, std::min(skipLimit, settings.obstacleEvents[nextObstacleEvent].tick - ticks));
+		ticks += robot.skipIdleTicks(settings.timeSlice, skipLimit);
+		if (isFinished())										// the skip mowed the last tile on its last tick
+			break;
+		step();
+	}
+	return getResult();
+}
+
+/*
+	returns the summary of the simulation so far
+*/
+SimulationResult Simulation::getResult()
+{
+	SimulationResult result;
+	result.ticks = ticks;
+	result.timePassed = robot.getTimePassed();
+	result.rechargeCount = robot.getRechargeCount();
+	result.tilesMowed = tileMap.getTilesMowed();
+	result.tilesToMow = tileMap.getTilesToMow();
+	const CoverageMap& coverage = tileMap.getCoverage();
+	result.coverage = coverage.getCoverage();
+	int middleRow = tileMap.getHeight() / 2, middleCol = tileMap.getWidth() / 2;
+	for (int i = 0; i < 4; i++) {
+		int rowMin = i < 2 ? 0 : middleRow, rowMax = i < 2 ? middleRow - 1 : tileMap.getHeight() - 1;
+		int colMin = i % 2 == 0 ? 0 : middleCol, colMax = i % 2 == 0 ? middleCol - 1 : tileMap.getWidth() - 1;
+		int lawn = coverage.countLawnInRegion(rowMin, colMin, rowMax, colMax);
+		result.quarterCoverage[i] = lawn > 0 ? (float)coverage.countMowedInRegion(rowMin, colMin, rowMax, colMax) / lawn : 1.f;
+	}
+	for (int row = 0; row < tileMap.getHeight(); row++) {
+		if (coverage.countMowedInRow(row) < coverage.countLawnInRegion(row, 0, row, tileMap.getWidth() - 1))
+			result.unfinishedRows++;
+	}
+	coverage.findFirstUnmowed(0, 0, result.firstUnmowedRow, result.firstUnmowedCol);
+	result.finished = isFinished() && !stuck;
+	result.stuck = stuck;
+	result.trajectoryHash = trajectoryHash.getHash();
+	result.pathSearches = robot.getPathFinder().getSearches();
+	result.expandedTiles = robot.getPathFinder().getTotalExpandedTiles();
+	result.pathCacheHits = robot.getPathFinder().getCacheHits();
+	result.routeLength = (long long)robot.getCoverageRoute().size();
+	result.routeCells = routeCells;
+	result.routeLegs = routeLegs;
+	if (settings.strategy == UpdateStrategy::ROUTE) {
+		result.legTilesMowed = legTilesMowed;
+		result.legTilesMowed.push_back(coverage.countMowedSince(legStart));
+	}
+	return result;
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "TileMap.h"
+#include "Robot.h"
+#include "TrajectoryHash.h"
+#include "CoveragePlanner.h"
+
+// which of the robot's update functions drives the simulation
+enum class UpdateStrategy {
+	BOUNCE,								// Robot::Update, old random bouncing logic
+	ZIGZAG,								// Robot::Update2, zigzag with path finding around obstacles
+	ROUTE,								// Robot::Update2 along a route planned for the whole map, see CoveragePlanner
+};
+
+// an obstacle put on or taken off the map during a run
+struct ObstacleEvent {
+	long long tick;						// tick the change happens at
+	int row;							// the tile
+	int col;
+	int foregroundTileNum;				// foreground type of the obstacle, -1 takes the obstacle away
+};
+
+// parameters of a simulation run
+struct SimulationSettings {
+	UpdateStrategy strategy = UpdateStrategy::ZIGZAG;
+	float timeSlice = 1.f / 100.f;		// fixed time step, in seconds (100th of a second like the windowed version)
+	IntegrationMode integrationMode = IntegrationMode::TICK;
+	CollisionMode collisionMode = CollisionMode::SAMPLED;	// SWEPT lets timeSlice be long without going through walls
+	KinematicsMode kinematicsMode = KinematicsMode::FLOAT;	// FIXED runs the same on any build
+	BounceMode bounceMode = BounceMode::RANDOM;	// how the robot picks a heading when it bounces
+	int bounceCandidates = 8;			// headings weighed per bounce, unused with BounceMode::RANDOM
+	std::vector<ChargeCurveBand> chargeCurve;	// empty means 1% per tick
+	PathPlanner pathPlanner = PathPlanner::BFS;	// search used for detours around obstacles
+	bool allowDiagonal = false;			// detours can move diagonally
+	ChargerReturn chargerReturn = ChargerReturn::PERIMETER;	// how the robot gets to a charger
+	ResumeMode resumeMode = ResumeMode::GOING_BACK;		// how the robot gets back to mowing after charging
+	std::shared_ptr<PathCache> pathCache;	// detours found before, shared by the runs of a batch, null for none
+	float routeLegReserve = -1;			// % of battery left at the end of a leg of the coverage route, -1 doesn't split it
+	std::shared_ptr<PlannerPool> plannerPool;	// searches detours on worker threads, shared by the runs of a batch, null for none
+	int planningDelay = 0;				// ticks the robot holds for a detour, -1 until the pool is done, see Robot::setPlannerPool
+	std::vector<ObstacleEvent> obstacleEvents;	// changes to the map during the run, in tick order
+	int startX = 1;						// starting tile of the robot
+	int startY = 1;
+	long long stuckTicks = 0;			// ticks without mowing a tile before the robot is considered stuck, 0 to disable
+	bool seeded = false;				// if false the robot seeds itself from std::random_device
+	unsigned long long seed = 0;		// seed of the robot's rng when seeded is true
+	unsigned long long stream = 0;		// stream of the seed, parallel runs use one stream each
+};
+
+// summary of a simulation run
+struct SimulationResult {
+	long long ticks = 0;				// number of fixed time steps simulated
+	float timePassed = 0;				// simulated time as reported by the robot, in HOURS
+	int rechargeCount = 0;				// number of times the robot recharged
+	int tilesMowed = 0;					// tiles mowed at the end of the run
+	int tilesToMow = 0;					// tiles left to mow at the end of the run
+	float coverage = 0;					// fraction of the lawn mowed at the end of the run, 0 to 1
+	float quarterCoverage[4] = { 0, 0, 0, 0 };	// coverage of the quarters of the map: top left, top right, bottom left, bottom right
+	int unfinishedRows = 0;				// rows with tiles left to mow
+	int firstUnmowedRow = -1;			// first tile left to mow in row major order, -1 if there's none
+	int firstUnmowedCol = -1;
+	bool finished = false;				// true if the robot finished before the tick limit
+	bool stuck = false;					// true if the run was stopped because the robot stopped mowing
+	unsigned long long trajectoryHash = 0;	// hash of the robot's state after every simulated tick, see TrajectoryHash
+	long long pathSearches = 0;			// detours searched for
+	long long expandedTiles = 0;		// tiles expanded by all the detour searches
+	long long pathCacheHits = 0;		// detour searches answered by the path cache
+	long long routeLength = 0;			// tiles of the coverage route, UpdateStrategy::ROUTE only
+	int routeCells = 0;					// boustrophedon cells the route covers
+	int routeLegs = 0;					// legs the route was split in, 1 if it wasn't
+	std::vector<int> legTilesMowed;		// tiles mowed on each leg of the route so far, the last one still going on
+};
+
+/*
+	A headless simulation of one robot on its own copy of a tile map.
+	Nothing here touches Blit3D, so it can run without a window as fast as the CPU allows.
+*/
+class Simulation
+{
+private:
+	// =========== DATA MEMBERS ==============
+	TileMap tileMap;					// the simulation's own copy of the map
+	Robot robot;						// the robot, points to tileMap above
+	SimulationSettings settings;		// parameters of the run
+	long long ticks = 0;				// ticks simulated so far
+	long long lastMowTick = 0;			// tick at which the last tile was mowed, for stuck detection
+	int lastTilesMowed = 0;				// tiles mowed at lastMowTick
+	bool stuck = false;					// the robot hasn't mowed a tile for settings.stuckTicks ticks
+	unsigned int nextObstacleEvent = 0;	// first of settings.obstacleEvents not applied yet
+	TrajectoryHash trajectoryHash;		// hash of the trajectory so far
+	int routeCells = 0;					// cells of the coverage route, see CoveragePlanner
+	int routeLegs = 0;					// legs of the coverage route
+	std::vector<int> legTilesMowed;		// tiles mowed on each leg of the route the robot is done with
+	CoverageMap::Snapshot legStart;		// the coverage when the current leg started
+	void applyObstacleEvents();
+public:
+	// =========== FUNCTIONS ====================
+	// refer to cpp files for more detailed explanation
+	Simulation(const TileMap& map, const SimulationSettings& settings = SimulationSettings());
+	Simulation(const Simulation&) = delete;
+	Simulation& operator=(const Simulation&) = delete;
+	void step();
+	bool isFinished();
+	SimulationResult run(long long maxTicks);
+	SimulationResult getResult();
+	static bool LoadObstacleEvents(std::string filename, std::vector<ObstacleEvent>& events);
+
+	// getters
+	TileMap& getTileMap() {
+		return tileMap;
+	}
+
+	Robot& getRobot() {
+		return robot;
+	}
+
+	long long getTicks() {
+		return ticks;
+	}
+
+	bool isStuck() {
+		return stuck;
+	}
+
+	const SimulationSettings& getSettings() {
+		return settings;
+	}
+};
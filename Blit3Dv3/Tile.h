@@ -1,36 +1,33 @@
 #pragma once
-#include "Blit3D.h"
-#include "Robot.h"
+/*
+	A tile of the map, the background and foreground types are indices in the sprite sheet.
+	What the types mean for the simulation is described by the Tileset and stored
+	in the flags plane of the TileMap.
+*/
 class Tile
 {
 private:
-	// static data members
-	static int chargingTileList[];			// types of tiles that are charging tile 
-	static int perimeterTileList[];			// types of tiles that are perimeters
+	static const unsigned short NO_TILE = 0xFFFF;	// stored foreground type when the tile has no foreground (-1)
 	// ====== DATA MEMBERS =========
-	int foregroundTileNum;					// type of foregroundTile 
-	int backgroundTileNum;					// type of backgroundTile
+	// tile types are the index of the tile in the sprite sheet, 16 bits are plenty
+	unsigned short foregroundTileNum = NO_TILE;	// type of foregroundTile 
+	unsigned short backgroundTileNum = 0;		// type of backgroundTile
 public:
-	// ============ FUNCTIONS ==========
-	CollisionType tileCollisionType();
-	bool isChargingTile();
-	bool isMowableTile();
-	void mow();
-
 	// getters/setters
-	int getBackgroundTile() {
+	int getBackgroundTile() const {
 		return backgroundTileNum;
 	}
 
 	void setBackgroundTile(int tileNum) {
-		backgroundTileNum = tileNum;
+		backgroundTileNum = (unsigned short)tileNum;
 	}
 
-	int getForegroundTile() {
-		return foregroundTileNum;
+	// returns -1 if the tile has no foreground
+	int getForegroundTile() const {
+		return foregroundTileNum == NO_TILE ? -1 : foregroundTileNum;
 	}
 
 	void setForegroundTile(int tileNum) {
-		foregroundTileNum = tileNum;
+		foregroundTileNum = tileNum == -1 ? NO_TILE : (unsigned short)tileNum;
 	}
 };
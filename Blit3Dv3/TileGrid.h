@@ -0,0 +1,49 @@
+#pragma once
+#include <cmath>
+
+// pixel size of a map tile, the simulation is built for one size (e.g. -DMOWER_TILE_SIZE=32 for a finer lawn)
+#ifndef MOWER_TILE_SIZE
+#define MOWER_TILE_SIZE 16
+#endif
+
+// pixel size of the tiles of the sprite sheet, drawn scaled to the map's tile size
+const int TILE_SPRITE_SIZE = 16;
+
+/*
+	Pixel and tile coordinate math of a tile size known at compile time, every conversion between
+	the two goes through here (see TileGrid below) instead of spelling out the size.
+	The size being a constant, the compiler turns the divisions of a power of two size into shifts
+	(int) and multiplications by the exact inverse (float), other sizes cost a division like before.
+	The robot is sized relative to the tile, 5 pixels from its center to its sides on 16 pixel tiles.
+*/
+template <int TileSize>
+struct BasicTileGrid {
+	static_assert(TileSize > 0, "tiles need a size");
+	static const int TILE_SIZE = TileSize;
+	static constexpr float TILE_SIZE_F = (float)TileSize;
+	static constexpr float ROBOT_HALF_SIZE = TileSize * 5 / 16.f;
+	static constexpr float SPRITE_SCALE = TileSize / (float)TILE_SPRITE_SIZE;
+
+	// tile of a pixel coordinate, rounded towards zero like the int division it replaces,
+	// pixels -1 to -(TILE_SIZE - 1) are still on tile 0
+	static int toTile(int pixel) {
+		return pixel / TileSize;
+	}
+
+	// tile of a pixel coordinate, rounded down, the tile left of or above pixel 0 is -1
+	static int floorTile(float pixel) {
+		return (int)std::floor(pixel / TILE_SIZE_F);
+	}
+
+	// pixel of the left or top edge of a tile
+	static int toPixel(int tile) {
+		return tile * TileSize;
+	}
+};
+
+template <int TileSize> const int BasicTileGrid<TileSize>::TILE_SIZE;
+template <int TileSize> constexpr float BasicTileGrid<TileSize>::TILE_SIZE_F;
+template <int TileSize> constexpr float BasicTileGrid<TileSize>::ROBOT_HALF_SIZE;
+template <int TileSize> constexpr float BasicTileGrid<TileSize>::SPRITE_SCALE;
+
+typedef BasicTileGrid<MOWER_TILE_SIZE> TileGrid;
@@ -1,16 +1,25 @@
 #include "TileMap.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include "CollisionType.h"
-extern int MAP_VIEW_SIZE;
+#include <atomic>
+#ifndef MOWER_HEADLESS
+#include "Blit3D.h"
 extern std::vector<Sprite*> tileSpriteList;
 extern Blit3D* blit3D;
+#endif
 
-int TileMap::TILE_SIZE_PIXEL = 16;
+// last map version handed out, shared by all maps so two maps never get the same version by accident
+static std::atomic<unsigned long long> lastVersion(0);
 /*
 * Constructor for this class, loads the map with the filename passed
+* the tileset describes the tile types of the map, see Tileset
 */
-TileMap::TileMap(std::string filename)
+TileMap::TileMap(std::string filename, const Tileset& tileset)
+	: tileset(tileset)
 {
 	LoadMap(filename);
 }
@@ -34,44 +43,55 @@ bool TileMap::LoadMap(std::string filename)
 	std::string currLine;
 	mapFile >> width;
 	mapFile >> height;
-	MAP_VIEW_HEIGHT = blit3D->screenHeight / 16;
-	MAP_VIEW_WIDTH = blit3D->screenWidth / 16;
-	// initialize map2d with height and width sizes
-	map2d = std::vector<std::vector<Tile>>(
-		height,
-		std::vector<Tile>(width));
+	tilesToMow = 0;
+	tilesMowed = 0;
+	solidEdits.clear();
+	version = ++lastVersion;
+	// initialize the tiles with height and width sizes
+	tiles = std::vector<Tile>(width * height);
+	tileFlags = std::vector<unsigned char>(width * height, 0);
+	coverage = CoverageMap(width, height);
+	perimeterNeighbours = std::vector<unsigned char>(width * height, 0);
+	obstacleNeighbours = std::vector<unsigned char>(width * height, 0);
 
 	// load background tiles
-	unsigned int i, j, tileNum;
-	for (i = 0; i < height; i++) {
-		for (j = 0; j < width; j++) {
-			Tile t;
-			mapFile >> tileNum;
-			t.setBackgroundTile(tileNum);
-			map2d[i][j] = t;
-		}
+	unsigned int i, tileNum;
+	for (i = 0; i < tiles.size(); i++) {
+		mapFile >> tileNum;
+		tiles[i].setBackgroundTile(tileNum);
 	}
 
 	// load foreground tiles
-	for (i = 0; i < height; i++) {
-		for (j = 0; j < width; j++) {
-			mapFile >> tileNum;
-			map2d[i][j].setForegroundTile(tileNum);
-		}
+	int foregroundTileNum;
+	for (i = 0; i < tiles.size(); i++) {
+		mapFile >> foregroundTileNum;
+		tiles[i].setForegroundTile(foregroundTileNum);
 	}
 
-	// analyze tiles and count mowable tiles
-	for (i = 0; i < height; i++) {
-		for (j = 0; j < width; j++) {
-			if (map2d[i][j].isMowableTile()) {
-				tilesToMow++;
-			}
+	// classify tiles, build the neighbourhood masks and count mowable tiles
+	for (i = 0; i < tiles.size(); i++) {
+		updateTile(i);
+		if (tileFlags[i] & TILE_MOWABLE) {
+			tilesToMow++;
 		}
 	}
+	// distances to the charging stations
+	chargerDistances = DistanceField(width, height);
+	chargerDistances.build(tileFlags);
 	mapFile.close();
 	return true;
 }
 
+/*
+	sets how many tiles are visible on a screen of the given size in pixels,
+	only used when drawing, a headless simulation never needs to call this
+*/
+void TileMap::setMapView(int screenWidth, int screenHeight)
+{
+	MAP_VIEW_HEIGHT = screenHeight / TileGrid::TILE_SIZE;
+	MAP_VIEW_WIDTH = screenWidth / TileGrid::TILE_SIZE;
+}
+
 /*
 	converts x and y to map position
 	NOTE: this is not relative to the current screen
@@ -80,7 +100,7 @@ bool TileMap::LoadMap(std::string filename)
 */ 
 glm::vec2 TileMap::toMapPosition(int x, int y)
 {
-	return glm::vec2((x / 16), (y / 16));
+	return glm::vec2(TileGrid::toTile(x), TileGrid::toTile(y));
 }
 /*
 	Helper function that converts glmvec2 position to glmvec2 tilemapposition
@@ -93,6 +113,7 @@ glm::vec2 TileMap::toMapPosition(glm::vec2 pixelPosition)
 	return toMapPosition(pixelPosition.x, pixelPosition.y);
 }
 
+#ifndef MOWER_HEADLESS
 /*
 	Draws the map that is only visible in the screen, since the robot is always at the center, 
 	we just pan the map around the center point at the same rate the robot is moving. (so it's much more efficient)
@@ -118,34 +139,36 @@ void TileMap::Draw(Robot* robot) {
 			tileIndex_X = col + colMin;
 			// get tile posistion in screen
 			// tile position - robot position (pixels) + robot screen position (which is always center)
-			tileScreenPosition_X = (tileIndex_X * 16) - (robot->getPosition().x) + robot->getScreenPosition().x;
-			tileScreenPosition_Y = blit3D->screenHeight - ((tileIndex_Y * 16) - (robot->getPosition().y) + robot->getScreenPosition().y);
+			tileScreenPosition_X = TileGrid::toPixel(tileIndex_X) - (robot->getPosition().x) + robot->getScreenPosition().x;
+			tileScreenPosition_Y = blit3D->screenHeight - (TileGrid::toPixel(tileIndex_Y) - (robot->getPosition().y) + robot->getScreenPosition().y);
 
 			// if out of bounds, render an ocean tile
 			if (!validMapPosition(tileIndex_X, tileIndex_Y))
 			{
-				tileSpriteList[210]->Blit(tileScreenPosition_X, tileScreenPosition_Y);
+				tileSpriteList[210]->Blit(tileScreenPosition_X, tileScreenPosition_Y, TileGrid::SPRITE_SCALE, TileGrid::SPRITE_SCALE);
 
 			} else { // else if not out of bounds
 				// get background and foreground tiles
-				bgTileIdx = map2d[tileIndex_Y][tileIndex_X].getBackgroundTile();
-				fgTileIdx = map2d[tileIndex_Y][tileIndex_X].getForegroundTile();
+				const Tile& tile = getTile(tileIndex_Y, tileIndex_X);
+				bgTileIdx = tile.getBackgroundTile();
+				fgTileIdx = tile.getForegroundTile();
 				// draw the tile
-				tileSpriteList[bgTileIdx]->Blit(tileScreenPosition_X, tileScreenPosition_Y);
+				tileSpriteList[bgTileIdx]->Blit(tileScreenPosition_X, tileScreenPosition_Y, TileGrid::SPRITE_SCALE, TileGrid::SPRITE_SCALE);
 				if (fgTileIdx != -1) {
 					// draw fg tile in the screen if a valid tile
-					tileSpriteList[fgTileIdx]->Blit(tileScreenPosition_X, tileScreenPosition_Y);
+					tileSpriteList[fgTileIdx]->Blit(tileScreenPosition_X, tileScreenPosition_Y, TileGrid::SPRITE_SCALE, TileGrid::SPRITE_SCALE);
 				}
 			}
 		}
 	}
 }
+#endif
 
 /*
 	checks if the tileMapPosition passed is valid in the loaded map,
 	returns true if it is a valid map position, else false
 */
-bool TileMap::validMapPosition(glm::vec2 tileMapPosition) {
+bool TileMap::validMapPosition(glm::vec2 tileMapPosition) const {
 	return validMapPosition(tileMapPosition.x, tileMapPosition.y);
 }
 
@@ -153,42 +176,252 @@ bool TileMap::validMapPosition(glm::vec2 tileMapPosition) {
 	checks if int x and int y are valid values in the map
 	returns true if it is a valid map position, else false
 */
-bool TileMap::validMapPosition(int x, int y) {
+bool TileMap::validMapPosition(int x, int y) const {
 	return (x >= 0 && y >= 0 && x < width && y < height);
 }
 
 /*
-	checks if the adjacent tiles of the given tileMapPosition has adjacent perimeter tiles
-	parameters: tileMapPosition - the position of the map to check
+	checks if the adjacent tiles of the given tileMapPosition has adjacent perimeter tiles,
+	a single lookup in the neighbourhood masks
+	parameters: tileMapPosition - the position of the map to check, x is the column and y the row
 	returns true if tileMapPosition has an adjacent perimeter
 */
 bool TileMap::hasPerimeterAdjacent(glm::vec2 tileMapPosition) {
-	Direction lookAheadDir[8] = {
-		Direction::LEFT,
-		Direction::RIGHT,
-		Direction::UP,
-		Direction::DOWN,
-		Direction::DOWN_LEFT,
-		Direction::DOWN_RIGHT,
-		Direction::UP_LEFT,
-		Direction::UP_RIGHT,
-	};
-	int directionsIndex, nextDirectionIndexX, nextDirectionIndexY;
-	Direction currDirection;
-	for (directionsIndex = 0; directionsIndex < 8; directionsIndex++) {	// for each directions
-		currDirection = lookAheadDir[directionsIndex];					// get the direction's x and y values
-		nextDirectionIndexX = tileMapPosition.x + Robot::directionTable[currDirection][0];	// get the next tile position based on the direction
-		nextDirectionIndexY = tileMapPosition.y + Robot::directionTable[currDirection][1];	
-		if (validMapPosition(nextDirectionIndexX, nextDirectionIndexY) &&					// if next tile is valid map position 
-			map2d[nextDirectionIndexX][nextDirectionIndexY].tileCollisionType() == CollisionType::PERIMETER) { // and tile is a perimeter
-			return true;	// return true if perimeter
+	return validMapPosition(tileMapPosition)
+		&& getPerimeterNeighbours(tileMapPosition.y, tileMapPosition.x) != 0;
+}
+
+/*
+	sweeps an axis aligned box along a straight line and finds the first tile it runs into, like
+	Robot::collisionCheck the box is closed, an edge right on a tile border already touches the next tile.
+	Walks the tiles the leading edges enter in the order they enter them (a DDA on each axis), so a box
+	moving several tiles in one step can't go through a thin wall the way checking the end position does.
+	Tiles the box already covers at the start are left out, a box that starts inside a solid tile can leave it.
+	parameters:
+		center			- center of the box, in pixels
+		halfSize		- half the size of the box
+		displacement	- the move, in pixels
+		hit				- set to the time, normal and tile of the first hit, time 1 and type NONE if none
+	returns true if the box runs into a solid tile or the edge of the map
+*/
+bool TileMap::sweepBox(glm::vec2 center, float halfSize, glm::vec2 displacement, SweepHit& hit) const {
+	const float tileSize = TileGrid::TILE_SIZE_F;
+	hit = SweepHit();
+	int first[2], last[2];						// per axis, tiles the box covers
+	int next[2] = { 0, 0 };						// tile the leading edge enters next
+	float nextTime[2], timeStep[2];				// when it enters it, and time to cross a tile
+	for (int axis = 0; axis < 2; axis++) {
+		float low = center[axis] - halfSize, high = center[axis] + halfSize, d = displacement[axis];
+		first[axis] = TileGrid::floorTile(low);
+		last[axis] = TileGrid::floorTile(high);
+		nextTime[axis] = FLT_MAX;
+		timeStep[axis] = 0;
+		if (d > 0) {
+			next[axis] = last[axis] + 1;
+			nextTime[axis] = (next[axis] * tileSize - high) / d;
+			timeStep[axis] = tileSize / d;
+		}
+		else if (d < 0) {
+			next[axis] = first[axis] - 1;
+			nextTime[axis] = (first[axis] * tileSize - low) / d;
+			timeStep[axis] = -tileSize / d;
+		}
+	}
+
+	while (true) {
+		int axis = nextTime[0] <= nextTime[1] ? 0 : 1;
+		float time = nextTime[axis];
+		if (time > 1.f)
+			return false;
+		int other = 1 - axis;
+		// the trailing edge on the other axis may have left a tile by then
+		float d = displacement[other];
+		if (d > 0)
+			first[other] = std::max(first[other], TileGrid::floorTile(center[other] - halfSize + d * time));
+		else if (d < 0)
+			last[other] = std::min(last[other], TileGrid::floorTile(center[other] + halfSize + d * time));
+		for (int i = first[other]; i <= last[other]; i++) {
+			int row = axis == 0 ? i : next[axis];
+			int col = axis == 0 ? next[axis] : i;
+			CollisionType type = validMapPosition(col, row) ? collisionType(row, col) : CollisionType::PERIMETER;
+			if (type != CollisionType::NONE) {
+				hit.time = time;
+				hit.normal[axis] = displacement[axis] > 0 ? -1.f : 1.f;
+				hit.row = row;
+				hit.col = col;
+				hit.type = type;
+				return true;
+			}
+		}
+		// the box covers the new tile, on to the one after
+		if (displacement[axis] > 0)
+			last[axis] = next[axis]++;
+		else
+			first[axis] = next[axis]--;
+		nextTime[axis] += timeStep[axis];
+	}
+}
+
+/*
+	walks the tiles a ray goes through, in order, until it enters a solid tile (Amanatides & Woo's grid traversal),
+	every tile the ray crosses is checked once whatever its length, corners included
+	parameters:
+		origin		- start of the ray, in pixels, the tile it's on counts
+		direction	- direction of the ray, doesn't need to be normalized
+		maxDistance	- length of the ray, in pixels
+		hit			- set to the distance, normal and tile of the first solid tile, distance is maxDistance if none,
+					  and to the mowable tiles the ray went through before it
+	returns true if the ray enters a solid tile or leaves the map within maxDistance
+	Reference used:
+		Amanatides, J., Woo, A. (1987). A Fast Voxel Traversal Algorithm for Ray Tracing. Eurographics '87.
+*/
+bool TileMap::raycast(glm::vec2 origin, glm::vec2 direction, float maxDistance, RayHit& hit) const {
+	const float tileSize = TileGrid::TILE_SIZE_F;
+	hit = RayHit();
+	float length = glm::length(direction);
+	if (length > 0)
+		direction /= length;
+	int tile[2], step[2];						// per axis, tile of the ray and which way it goes
+	float nextDistance[2], distanceStep[2];		// distance to the next tile border, and between two borders
+	for (int axis = 0; axis < 2; axis++) {
+		tile[axis] = TileGrid::floorTile(origin[axis]);
+		step[axis] = 0;
+		nextDistance[axis] = FLT_MAX;
+		distanceStep[axis] = 0;
+		if (direction[axis] > 0) {
+			step[axis] = 1;
+			nextDistance[axis] = ((tile[axis] + 1) * tileSize - origin[axis]) / direction[axis];
+			distanceStep[axis] = tileSize / direction[axis];
+		}
+		else if (direction[axis] < 0) {
+			step[axis] = -1;
+			nextDistance[axis] = (tile[axis] * tileSize - origin[axis]) / direction[axis];
+			distanceStep[axis] = -tileSize / direction[axis];
+		}
+	}
+
+	int axis = -1;								// axis of the last border crossed
+	float distance = 0;
+	while (true) {
+		int row = tile[1], col = tile[0];
+		CollisionType type = validMapPosition(col, row) ? collisionType(row, col) : CollisionType::PERIMETER;
+		if (type != CollisionType::NONE) {
+			hit.distance = distance;
+			if (axis != -1)
+				hit.normal[axis] = (float)-step[axis];
+			hit.row = row;
+			hit.col = col;
+			hit.type = type;
+			return true;
 		}
+		if (axis != -1 && isMowableTile(row, col))
+			hit.mowableTiles++;
+		axis = nextDistance[0] <= nextDistance[1] ? 0 : 1;
+		distance = nextDistance[axis];
+		if (distance > maxDistance) {
+			hit.distance = maxDistance;
+			return false;
+		}
+		tile[axis] += step[axis];
+		nextDistance[axis] += distanceStep[axis];
 	}
-	return false;			// return false, means each direction hasn't found a perimeter beside a tile
 }
 
 void TileMap::mowTile(int row, int col) {
 	tilesToMow--;
 	tilesMowed++;
-	map2d[row][col].mow();
+	int index = tileIndex(row, col);
+	tiles[index].setBackgroundTile(tileset.getMowedTile());	// turn tile into mowed
+	updateTile(index);
+}
+
+/*
+	changes the background and foreground types of a tile while the map is in use
+	(e.g. placing or removing an obstacle) and keeps the tile counters up to date
+	parameters:
+		row, col			- the tile to change, must be a valid map position
+		backgroundTileNum	- new background type
+		foregroundTileNum	- new foreground type, -1 for no foreground
+*/
+void TileMap::setTile(int row, int col, int backgroundTileNum, int foregroundTileNum) {
+	int index = tileIndex(row, col);
+	unsigned char previousFlags = tileFlags[index];
+	tiles[index].setBackgroundTile(backgroundTileNum);
+	tiles[index].setForegroundTile(foregroundTileNum);
+	updateTile(index);
+	if ((previousFlags ^ tileFlags[index]) & TILE_SOLID) {
+		solidEdits.push_back(index);
+		version = ++lastVersion;
+	}
+	if ((previousFlags ^ tileFlags[index]) & (TILE_SOLID | TILE_CHARGING))
+		chargerDistances.update(tileFlags, index, previousFlags);
+	if ((previousFlags & TILE_MOWABLE) && !(tileFlags[index] & TILE_MOWABLE))
+		tilesToMow--;
+	else if (!(previousFlags & TILE_MOWABLE) && (tileFlags[index] & TILE_MOWABLE))
+		tilesToMow++;
+}
+
+/*
+	puts an obstacle (parked equipment, a person...) on a tile while the map is in use,
+	the tile keeps its background so the grass under it is mowable again once it's removed
+	parameters:
+		row, col			- the tile, must be a valid map position
+		foregroundTileNum	- foreground type of the obstacle, any type the tileset doesn't list as a perimeter
+*/
+void TileMap::placeObstacle(int row, int col, int foregroundTileNum) {
+	setTile(row, col, getTile(row, col).getBackgroundTile(), foregroundTileNum);
+}
+
+/*
+	takes away whatever is on a tile while the map is in use, see placeObstacle
+*/
+void TileMap::removeObstacle(int row, int col) {
+	setTile(row, col, getTile(row, col).getBackgroundTile(), -1);
+}
+
+/*
+	reclassifies a tile after its types changed and updates its coverage bits
+*/
+void TileMap::updateTile(int index) {
+	unsigned char flags = tileset.classify(tiles[index].getBackgroundTile(), tiles[index].getForegroundTile());
+	unsigned char previousFlags = tileFlags[index];
+	tileFlags[index] = flags;
+	if ((flags ^ previousFlags) & (TILE_PERIMETER | TILE_OBSTACLE))
+		updateNeighbourMasks(index / width, index % width, flags);
+	bool isMowed = (flags & TILE_MOWED) && !(flags & TILE_SOLID);
+	coverage.setTile(index / width, index % width, isMowed || (flags & TILE_MOWABLE), isMowed);
+}
+
+/*
+	sets the bits of a tile in the neighbourhood masks of its 8 neighbours,
+	called when the tile turns into or stops being a perimeter or obstacle tile
+*/
+void TileMap::updateNeighbourMasks(int row, int col, unsigned char flags) {
+	// the neighbour in direction d sees this tile in the opposite direction
+	static const Direction oppositeDirection[DIRECTION_COUNT] = {
+		RIGHT,			// LEFT
+		DOWN_RIGHT,		// UP_LEFT
+		UP_RIGHT,		// DOWN_LEFT
+		LEFT,			// RIGHT
+		DOWN_LEFT,		// UP_RIGHT
+		UP_LEFT,		// DOWN_RIGHT
+		DOWN,			// UP
+		UP,				// DOWN
+	};
+	for (int direction = 0; direction < DIRECTION_COUNT; direction++) {
+		int neighbourCol = col + (int)Robot::directionTable[direction][0];
+		int neighbourRow = row + (int)Robot::directionTable[direction][1];
+		if (!validMapPosition(neighbourCol, neighbourRow))
+			continue;
+		int neighbourIndex = tileIndex(neighbourRow, neighbourCol);
+		unsigned char bit = neighbourBit(oppositeDirection[direction]);
+		if (flags & TILE_PERIMETER)
+			perimeterNeighbours[neighbourIndex] |= bit;
+		else
+			perimeterNeighbours[neighbourIndex] &= ~bit;
+		if (flags & TILE_OBSTACLE)
+			obstacleNeighbours[neighbourIndex] |= bit;
+		else
+			obstacleNeighbours[neighbourIndex] &= ~bit;
+	}
 }
\ No newline at end of file
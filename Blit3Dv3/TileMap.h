@@ -2,47 +2,165 @@
 #include <vector>
 #include <string>
 #include <random>
-#include "Blit3D.h"
+#include <glm/glm.hpp>
 #include "Robot.h"
 #include "Tile.h"
+#include "Tileset.h"
+#include "CoverageMap.h"
+#include "DistanceField.h"
+#include "TileGrid.h"
+
+// first tile a box moving in a straight line runs into, see TileMap::sweepBox
+struct SweepHit {
+	float time = 1.f;								// fraction of the displacement done when the box touches the tile, 1 if it doesn't
+	glm::vec2 normal = glm::vec2(0, 0);				// side of the tile that was hit, pointing back at the box
+	int row = -1;									// the tile, -1 if no hit
+	int col = -1;
+	CollisionType type = CollisionType::NONE;		// collision type of the tile, tiles outside the map are PERIMETER
+};
+
+// first solid tile along a ray, see TileMap::raycast
+struct RayHit {
+	float distance = 0;								// pixels from the origin to where the ray enters the tile
+	glm::vec2 normal = glm::vec2(0, 0);				// side of the tile the ray entered through, zero if it starts in it
+	int row = -1;									// the tile, -1 if no hit
+	int col = -1;
+	CollisionType type = CollisionType::NONE;		// collision type of the tile, tiles outside the map are PERIMETER
+	int mowableTiles = 0;							// mowable tiles the ray went through on the way, not the one it starts on
+};
 
 class TileMap
 {
 private:
 	// =========== DATA MEMBERS ==============
-	static int TILE_SIZE_PIXEL;
-	// 2d vector that has tile classes
-	std::vector<std::vector<Tile>> map2d;
+	// tiles of the map in a single row major array, the tile at (row, col) is at row * width + col
+	std::vector<Tile> tiles;
+	// flags of each tile (see TileFlag), same layout as tiles, computed once at load and on mow/edit
+	// so the hot loops get the collision type, charging and mowing state of a tile with one byte lookup
+	std::vector<unsigned char> tileFlags;
+	// neighbourhood masks of each tile, same layout as tiles, bit d is set when the neighbour
+	// in Direction d is a perimeter (obstacle) tile, kept up to date when tiles are edited
+	std::vector<unsigned char> perimeterNeighbours;
+	std::vector<unsigned char> obstacleNeighbours;
+	// tiles that turned solid or open since the map was loaded, in order, see setTile
+	std::vector<int> solidEdits;
+	// identifies what's solid on the map, a new number every time a tile turns solid or open,
+	// copies of a map share it until one of them is edited, see PathCache
+	unsigned long long version = 0;
+	// what the tile types mean
+	Tileset tileset;
+	// one bit per tile of the mowed lawn, for coverage statistics
+	CoverageMap coverage;
+	// steps from every tile to the nearest charging station, kept up to date when tiles are edited
+	DistanceField chargerDistances;
 	// width of the tilemap
 	int width = 0;
 	// height of the tilemap
 	int height = 0;
 	// pixel size of each tile
 	// the height of the map visible in the screen
-	int MAP_VIEW_HEIGHT;
+	int MAP_VIEW_HEIGHT = 0;
 	// the width of the map visible in the screen
-	int MAP_VIEW_WIDTH;
+	int MAP_VIEW_WIDTH = 0;
 	// tiles left to mow
 	int tilesToMow = 0;
 	// tiles mowed;
 	int tilesMowed = 0;
 	bool isTileInView(int x, int y, Robot* robot);
+	void updateTile(int index);
+	void updateNeighbourMasks(int row, int col, unsigned char flags);
 public:
 	// =========== FUNCTIONS ====================
 	// refer to cpp files for more detailed explanation
-	TileMap(std::string filename);
+	TileMap(std::string filename, const Tileset& tileset = Tileset());
 	bool LoadMap(std::string filename);
+	void setMapView(int screenWidth, int screenHeight);
 	glm::vec2 toMapPosition(glm::vec2 pixelPosition);
 	glm::vec2 toMapPosition(int x, int y);
 	void Draw(Robot* robot);
-	bool validMapPosition(glm::vec2 tileMapPosition);
-	bool validMapPosition(int x, int y);
+	bool validMapPosition(glm::vec2 tileMapPosition) const;
+	bool validMapPosition(int x, int y) const;
 	bool hasPerimeterAdjacent(glm::vec2 tileMapPosition);
+	bool sweepBox(glm::vec2 center, float halfSize, glm::vec2 displacement, SweepHit& hit) const;
+	bool raycast(glm::vec2 origin, glm::vec2 direction, float maxDistance, RayHit& hit) const;
 	void mowTile(int row, int col);
+	void setTile(int row, int col, int backgroundTileNum, int foregroundTileNum);
+	void placeObstacle(int row, int col, int foregroundTileNum);
+	void removeObstacle(int row, int col);
 
 	// getters and setters
-	Tile getTile(int row, int col) {
-		return map2d[row][col];
+	int tileIndex(int row, int col) const {
+		return row * width + col;
+	}
+
+	const Tile& getTile(int row, int col) const {
+		return tiles[tileIndex(row, col)];
+	}
+
+	unsigned char getTileFlags(int row, int col) const {
+		return tileFlags[tileIndex(row, col)];
+	}
+
+	// the lookups below need a valid map position
+
+	// returns true if the robot collides with the tile
+	bool isSolid(int row, int col) const {
+		return (tileFlags[tileIndex(row, col)] & TILE_SOLID) != 0;
+	}
+
+	// returns the collision type of the tile, NONE, PERIMETER or OBSTACLE
+	CollisionType collisionType(int row, int col) const {
+		static const CollisionType collisionTypes[4] = {
+			CollisionType::NONE,			// neither bit
+			CollisionType::PERIMETER,		// TILE_PERIMETER
+			CollisionType::OBSTACLE,		// TILE_OBSTACLE
+			CollisionType::PERIMETER,		// both, can't happen
+		};
+		return collisionTypes[(tileFlags[tileIndex(row, col)] >> 1) & 3];
+	}
+
+	// bit of a direction in the neighbourhood masks
+	static unsigned char neighbourBit(Direction direction) {
+		return (unsigned char)(1 << direction);
+	}
+
+	// which of the 8 neighbours of the tile are perimeter tiles, see neighbourBit
+	unsigned char getPerimeterNeighbours(int row, int col) const {
+		return perimeterNeighbours[tileIndex(row, col)];
+	}
+
+	// which of the 8 neighbours of the tile are obstacle tiles, see neighbourBit
+	unsigned char getObstacleNeighbours(int row, int col) const {
+		return obstacleNeighbours[tileIndex(row, col)];
+	}
+
+	bool isChargingTile(int row, int col) const {
+		return (tileFlags[tileIndex(row, col)] & TILE_CHARGING) != 0;
+	}
+
+	bool isMowableTile(int row, int col) const {
+		return (tileFlags[tileIndex(row, col)] & TILE_MOWABLE) != 0;
+	}
+
+	const Tileset& getTileset() const {
+		return tileset;
+	}
+
+	// tile indices of the tiles that turned solid or open, users remember how many they've seen
+	const std::vector<int>& getSolidEdits() const {
+		return solidEdits;
+	}
+
+	unsigned long long getVersion() const {
+		return version;
+	}
+
+	const CoverageMap& getCoverage() const {
+		return coverage;
+	}
+
+	const DistanceField& getChargerDistances() const {
+		return chargerDistances;
 	}
 
 	int getTilesToMow() {
@@ -61,11 +179,11 @@ public:
 		return MAP_VIEW_HEIGHT;
 	}
 
-	int getHeight() {
+	int getHeight() const {
 		return height;
 	}
 
-	int getWidth() {
+	int getWidth() const {
 		return width;
 	}
 
@@ -0,0 +1,100 @@
+#include "Tileset.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+/*
+	Constructor, describes the BOF22 sprite sheet
+*/
+Tileset::Tileset()
+{
+	int perimeterTileList[] = {
+		26, 28, 29, 59,
+		57, 85, 84, 93,
+		63, 34, 33, 3
+	};
+	int chargingTileList[] = {
+		279, 281, 339, 341
+	};
+	grassTile = 7;
+	mowedTile = 11;
+	for (unsigned int i = 0; i < 12; i++)
+		setForegroundFlags(perimeterTileList[i], TILE_SOLID | TILE_PERIMETER);
+	for (unsigned int i = 0; i < 4; i++)
+		setBackgroundFlags(chargingTileList[i], TILE_CHARGING);
+	setBackgroundFlags(grassTile, TILE_MOWABLE);
+	setBackgroundFlags(mowedTile, TILE_MOWED);
+}
+
+void Tileset::setBackgroundFlags(int tileNum, unsigned char flags)
+{
+	if (tileNum >= (int)backgroundFlags.size())
+		backgroundFlags.resize(tileNum + 1, 0);
+	backgroundFlags[tileNum] = flags;
+}
+
+void Tileset::setForegroundFlags(int tileNum, unsigned char flags)
+{
+	// foreground tiles that are not described are obstacles
+	if (tileNum >= (int)foregroundFlags.size())
+		foregroundFlags.resize(tileNum + 1, TILE_SOLID | TILE_OBSTACLE);
+	foregroundFlags[tileNum] = flags;
+}
+
+/*
+	loads a tileset description, each line is a keyword followed by tile types:
+		perimeter 26 28 29 ...		foreground tiles that are perimeters (any other foreground is an obstacle)
+		charging 279 281 ...		background tiles that are charging stations
+		grass 7						background tile of a mowable tile
+		mowed 11					background tile of a mowed tile
+	returns true if the file was loaded, false if it can't be opened
+*/
+bool Tileset::LoadTileset(std::string filename)
+{
+	std::ifstream tilesetFile;
+	tilesetFile.open(filename);
+	if (!tilesetFile.is_open()) {
+		std::cout << "Can't open tileset file!" << std::endl;
+		return false;
+	}
+	backgroundFlags.clear();
+	foregroundFlags.clear();
+	std::string line, keyword;
+	int tileNum;
+	while (std::getline(tilesetFile, line)) {
+		std::istringstream lineStream(line);
+		if (!(lineStream >> keyword))
+			continue;
+		while (lineStream >> tileNum) {
+			if (keyword == "perimeter")
+				setForegroundFlags(tileNum, TILE_SOLID | TILE_PERIMETER);
+			else if (keyword == "charging")
+				setBackgroundFlags(tileNum, TILE_CHARGING);
+			else if (keyword == "grass")
+				grassTile = tileNum;
+			else if (keyword == "mowed")
+				mowedTile = tileNum;
+		}
+	}
+	setBackgroundFlags(grassTile, TILE_MOWABLE);
+	setBackgroundFlags(mowedTile, TILE_MOWED);
+	return true;
+}
+
+/*
+	computes the flags (see TileFlag) of a tile from its background and foreground types
+	a tile with a foreground on it is never mowable
+*/
+unsigned char Tileset::classify(int backgroundTileNum, int foregroundTileNum) const
+{
+	unsigned char flags = backgroundTileNum >= 0 && backgroundTileNum < (int)backgroundFlags.size()
+		? backgroundFlags[backgroundTileNum]
+		: 0;
+	if (foregroundTileNum != -1) {
+		flags &= ~TILE_MOWABLE;
+		flags |= foregroundTileNum >= 0 && foregroundTileNum < (int)foregroundFlags.size()
+			? foregroundFlags[foregroundTileNum]
+			: TILE_SOLID | TILE_OBSTACLE;
+	}
+	return flags;
+}
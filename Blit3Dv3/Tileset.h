@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// bits of the per tile flags plane of the TileMap
+enum TileFlag : unsigned char {
+	TILE_SOLID = 1 << 0,				// the robot collides with the tile (obstacle or perimeter)
+	TILE_PERIMETER = 1 << 1,			// foreground is a perimeter tile
+	TILE_OBSTACLE = 1 << 2,				// foreground is any other tile
+	TILE_CHARGING = 1 << 3,				// background is a charging station tile
+	TILE_MOWABLE = 1 << 4,				// grass that still needs mowing, with nothing on top of it
+	TILE_MOWED = 1 << 5,				// mowed grass
+};
+
+/*
+	Describes what the tile types (indices in the sprite sheet) of a map mean for the simulation,
+	so the lists of perimeter and charging tiles aren't hard-coded in the classes that use them.
+	The default constructor describes the BOF22 sprite sheet used by the maps in this project.
+*/
+class Tileset
+{
+private:
+	// =========== DATA MEMBERS ==============
+	std::vector<unsigned char> backgroundFlags;	// flags of each background tile type
+	std::vector<unsigned char> foregroundFlags;	// flags of each foreground tile type
+	int grassTile;								// background of a mowable tile
+	int mowedTile;								// background of a tile once it's mowed
+	void setBackgroundFlags(int tileNum, unsigned char flags);
+	void setForegroundFlags(int tileNum, unsigned char flags);
+public:
+	// =========== FUNCTIONS ====================
+	// refer to cpp files for more detailed explanation
+	Tileset();
+	bool LoadTileset(std::string filename);
+	unsigned char classify(int backgroundTileNum, int foregroundTileNum) const;
+
+	// getters
+	int getGrassTile() const {
+		return grassTile;
+	}
+
+	int getMowedTile() const {
+		return mowedTile;
+	}
+};
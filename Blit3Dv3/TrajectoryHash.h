@@ -0,0 +1,51 @@
+#pragma once
+#include <cstring>
+#include "Robot.h"
+
+/*
+	Running hash of a robot's trajectory, records the state of the robot after every tick.
+	Two runs with the same map, seed and settings must end with the same hash,
+	the windowed and the headless versions use it to check they simulate the same thing.
+	Uses 64 bit FNV-1a over the bits of the robot's state.
+*/
+class TrajectoryHash
+{
+private:
+	unsigned long long hash = 14695981039346656037ull;	// FNV offset basis
+	long long ticks = 0;								// ticks recorded
+
+	void add(const void* data, size_t size) {
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;					// FNV prime
+		}
+	}
+
+	void addFloat(float value) {
+		unsigned int bits;
+		memcpy(&bits, &value, sizeof(bits));
+		add(&bits, sizeof(bits));
+	}
+public:
+	// adds the current state of the robot to the hash
+	void record(Robot& robot) {
+		int state = (int)robot.getState();
+		add(&state, sizeof(state));
+		addFloat(robot.getPosition().x);
+		addFloat(robot.getPosition().y);
+		addFloat(robot.getVelocity().x);
+		addFloat(robot.getVelocity().y);
+		addFloat(robot.getBattery());
+		addFloat(robot.getTimePassed());
+		ticks++;
+	}
+
+	unsigned long long getHash() {
+		return hash;
+	}
+
+	long long getTicks() {
+		return ticks;
+	}
+};
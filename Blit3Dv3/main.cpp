@@ -4,6 +4,7 @@ Example program that shows how to display tile maps
 #include "Blit3D.h"
 #include "TileMap.h"
 #include "Robot.h"
+#include "TrajectoryHash.h"
 
 Blit3D *blit3D = NULL;
 
@@ -20,6 +21,7 @@ Blit3D *blit3D = NULL;
 #include <crtdbg.h>
 #include <iomanip>
 #include <sstream>
+#include <cstring>
 
 //GLOBAL DATA
 //sprite pointers
@@ -36,7 +38,18 @@ float elapsedTime = 0;
 // time slice of 100th of a second
 float timeSlice = 1.f / 100.f;
 
-Robot* robot;
+Robot* robot = NULL;
+
+// seed of the robot, set with --seed N, so the run can be compared with the headless runner
+bool robotSeeded = false;
+unsigned long long robotSeed = 0;
+// set with --async-planning DELAY, detours are searched on a worker thread so a long search doesn't
+// stall the frame, the robot holds DELAY ticks for each (-1 until the worker is done)
+bool asyncPlanning = false;
+int planningDelay = 0;
+// hash of the trajectory, printed when the robot finishes (same as mowersim --seed N --integration tick)
+TrajectoryHash trajectoryHash;
+bool trajectoryPrinted = false;
 
 void Init()
 {
@@ -51,22 +64,27 @@ void Init()
 
 	//load individual 16x16 tiles
 	unsigned int x, y;
-	for (y = 0; y < 256 / 16; ++y)
+	for (y = 0; y < 256 / TILE_SPRITE_SIZE; ++y)
 	{
-		for (x = 0; x < 480 / 16; ++x)
+		for (x = 0; x < 480 / TILE_SPRITE_SIZE; ++x)
 		{
-			tileSpriteList.push_back(blit3D->MakeSprite(x * 16, y * 16, 16, 16, "Media\\BOF22_edited.png"));
+			tileSpriteList.push_back(blit3D->MakeSprite(x * TILE_SPRITE_SIZE, y * TILE_SPRITE_SIZE, TILE_SPRITE_SIZE, TILE_SPRITE_SIZE, "Media\\BOF22_edited.png"));
 		}
 	}
 
 	tileMap = new TileMap("mapfile.dat");
+	tileMap->setMapView(blit3D->screenWidth, blit3D->screenHeight);
 
-	robot = new Robot(1, 1, robotSprite);
+	robot = new Robot(tileMap, 1, 1, robotSprite);
+	robot->centerOnScreen(blit3D->screenHeight);
+	if (robotSeeded) robot->setSeed(robotSeed);
+	if (asyncPlanning) robot->setPlannerPool(std::make_shared<PlannerPool>(1), planningDelay);
 
 }
 
 void DeInit(void)
 {
+	if (robot) delete robot;
 	if (tileMap) delete tileMap;
 }
 
@@ -82,8 +100,16 @@ void Update(double seconds)
 		// old method of clearing tiles
 		//robot->Update(timeSlice);
 		// new method of clearing tiles
+		bool robotRunning = robot->getState() != RobotState::STOP && tileMap->getTilesToMow() != 0;
 		robot->Update2(timeSlice);
-
+		if (robotRunning) {
+			trajectoryHash.record(*robot);
+		}
+		else if (trajectoryHash.getTicks() > 0 && !trajectoryPrinted) {
+			std::cout << "ticks: " << trajectoryHash.getTicks()
+				<< " trajectory: " << std::hex << trajectoryHash.getHash() << std::dec << std::endl;
+			trajectoryPrinted = true;
+		}
 	}
 }
 
@@ -203,6 +229,17 @@ int main(int argc, char *argv[])
 	//memory leak detection
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 
+	for (int i = 1; i + 1 < argc; i++) {
+		if (strcmp(argv[i], "--seed") == 0) {
+			robotSeeded = true;
+			robotSeed = strtoull(argv[i + 1], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--async-planning") == 0) {
+			asyncPlanning = true;
+			planningDelay = atoi(argv[i + 1]);
+		}
+	}
+
 	blit3D = new Blit3D(Blit3DWindowModel::DECORATEDWINDOW, 1280, 768);
 	//blit3D = new Blit3D(Blit3DWindowModel::FULLSCREEN, 920, 680);
 